@@ -31,6 +31,7 @@ http://www.sgi.com/tech/stl/stl_introduction.html
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include "xny/seq_kernel.hpp"
 
 namespace xny{
 
@@ -49,24 +50,10 @@ namespace xny{
 		}
 	}
 
+	/* 2 bit code of ACGTacgt, -1 for any other char */
 	inline int char2bits (char c) {
-		int cvalue = -1;
-		switch (std::toupper(c)) {
-			case 'A':
-				cvalue = 0;
-				break;
-			case 'C':
-				cvalue = 1;
-				break;
-			case 'G':
-				cvalue = 2;
-				break;
-			case 'T':
-				cvalue = 3;
-				break;
-		}
-		if (cvalue != -1) return cvalue;
-		else return -1;
+		int cvalue = seq_code_table ()[(unsigned char) c];
+		return cvalue < 4 ? cvalue : -1;
 	} // char2bits
 
 	inline void remove_gap (std::string& seq) {
@@ -143,14 +130,7 @@ namespace xny{
 
 	/* check if the char is a proper nucleotide (acgtACGT) or not */
 	inline bool is_nt (char c) {
-		switch (std::toupper(c)) {
-		case 'A':
-		case 'C':
-		case 'G':
-		case 'T':
-			return true;
-		default: return false;
-		}
+		return seq_code_table ()[(unsigned char) c] < 4;
 	}// is_nt
 
 	/* check if the oligo consists of acgt/ACGT only */
@@ -185,54 +165,21 @@ namespace xny{
 	}
 	/* Convert an input DNA string (will not be modified)
 	 * to its reverse complementary; the result is stored in another string.
-	 * All non-ACGTacgt characters will be returned as 'n'
+	 * All non-ACGTacgt characters will be returned as 'N'
 	 */
-	inline std::string get_rvc_str (std::string fwd) {
-		std::reverse(fwd.begin(), fwd.end());
-		for (int i = 0; i < (int) fwd.length(); ++ i) {
-			fwd[i] = get_rvc_base (fwd[i]);
-		}
-		return fwd;
+	inline std::string get_rvc_str (const std::string& fwd) {
+		std::string rvc (fwd.length(), 'N');
+		if (! fwd.empty()) seq_rvc (fwd.data(), fwd.length(), &rvc[0], 'N');
+		return rvc;
 	} // get_rvc_str
 
 	/* @brief 	The input DNA string [fwd] is converted to its rvc, the
 	 * 			result is stored in [fwd].
-	 * @note		All non-ACGTacgt characters will be returned as 'n'
+	 * @note		All non-ACGTacgt characters will be returned as 'N'
 	 */
 	inline void rvc_str (std::string& fwd) {
-		std::reverse(fwd.begin(), fwd.end());
-		for (int i = 0; i < (int) fwd.length(); ++ i){
-			switch (fwd.at(i)){
-			case 'A':
-				fwd[i] = 'T';
-				break;
-			case 'T':
-				fwd[i] = 'A';
-				break;
-			case 'C':
-				fwd[i] = 'G';
-				break;
-			case 'G':
-				fwd[i] = 'C';
-				break;
-			case 'a':
-				fwd[i] = 't';
-				break;
-			case 't':
-				fwd[i] = 'a';
-				break;
-			case 'c':
-				fwd[i] = 'g';
-				break;
-			case 'g':
-				fwd[i] = 'c';
-				break;
-			default:
-				fwd[i] = 'N';
-				break;
-			}
-		}
-	} // get_rvc_str
+		if (! fwd.empty()) seq_rvc (&fwd[0], fwd.length(), &fwd[0], 'N');
+	} // rvc_str
 	/*
 	 * extract all kmers (including duplicated ones) in bit form from a
 	 * DNA sequence, including forward and/or reverse complementary
@@ -363,8 +310,8 @@ namespace xny{
 		std::string kmer, rcKmer;
 		kmer = seq.substr(0, k);
 		rcKmer = get_rvc_str (kmer);
-		std::transform(kmer.begin(), kmer.end(), kmer.begin(), toupper);
-		std::transform(rcKmer.begin(), rcKmer.end(), rcKmer.begin(), toupper);
+		seq_upper (&kmer[0], kmer.length());
+		seq_upper (&rcKmer[0], rcKmer.length());
 
 		switch (code) {
 			case 0:
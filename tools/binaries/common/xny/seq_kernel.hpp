@@ -0,0 +1,402 @@
+//============================================================================
+// Name        : seq_kernel.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute, 2026
+// Description : Byte-level DNA sequence kernels shared by M-Vicuna and
+//				 V-Phaser, whose makefiles add tools/binaries/common to
+//				 the include path
+//============================================================================
+
+
+#ifndef SEQ_KERNEL_HPP_
+#define SEQ_KERNEL_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+/* run time selection of SSSE3/AVX2 code compiled through target attributes */
+#if (defined (__x86_64__) || defined (__i386__)) && (defined (__clang__) || \
+	(defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+  #define XNY_SEQ_KERNEL_DISPATCH
+  #include <immintrin.h>
+#endif
+
+namespace xny{
+	/**
+	 * Kernels over DNA strings, each with a scalar version and, on x86
+	 * with GCC >= 4.9 or clang, SSSE3 and AVX2 versions that are selected
+	 * once by CPUID (no -m flags needed, the binary runs on any x86):
+	 *
+	 *   seq_upper   ASCII case folding in place
+	 *   seq_encode  2 bit codes of ACGTacgt (A 0, C 1, G 2, T 3), 4 for
+	 *               any other char; returns the number of the latter
+	 *   seq_rvc     reverse complement, case preserved, any non-ACGTacgt
+	 *               char becomes [other]; [in] may equal [out]
+	 *   seq_pack    codes 0-3 packed 4 per byte, first base lowest
+	 *   seq_kmers   k-mers (k <= 32) of codes, 2 bits per base with the
+	 *               first base highest, and their start positions;
+	 *               windows with a code 4 are skipped. The rolling update
+	 *               is serial, so its scalar version serves every
+	 *               instruction set, after a vectorised seq_encode
+	 *
+	 * All versions give identical results; seq_kernel (isa) returns the
+	 * kernels of a given instruction set (capped by the CPU), e.g. to
+	 * compare or time them.
+	 */
+	enum seq_isa { SEQ_SCALAR = 0, SEQ_SSSE3 = 1, SEQ_AVX2 = 2 };
+
+	struct seq_kernel_t {
+		void (*upper) (char* s, size_t n);
+		size_t (*encode) (const char* s, size_t n, uint8_t* code);
+		void (*rvc) (const char* in, size_t n, char* out, char other);
+		void (*pack) (const uint8_t* code, size_t n, uint8_t* packed);
+		size_t (*kmers) (const uint8_t* code, size_t n, int k,
+				uint64_t* kmer, uint32_t* pos);
+		seq_isa isa;
+	}; // struct seq_kernel_t
+
+	/* code of ACGTacgt, 4 for any other char */
+	inline const uint8_t* seq_code_table () {
+		struct table_t {
+			uint8_t code[256];
+			table_t () {
+				std::memset (code, 4, sizeof (code));
+				const char* acgt = "ACGTacgt";
+				for (int i = 0; i < 8; ++ i) code[(unsigned char) acgt[i]] = i % 4;
+			}
+		};
+		static const table_t table;
+		return table.code;
+	} // seq_code_table
+
+	/* complement of ACGTacgt, 0 for any other char */
+	inline const char* seq_complement_table () {
+		struct table_t {
+			char base[256];
+			table_t () {
+				std::memset (base, 0, sizeof (base));
+				const char* from = "ACGTacgt", *to = "TGCAtgca";
+				for (int i = 0; i < 8; ++ i) base[(unsigned char) from[i]] = to[i];
+			}
+		};
+		static const table_t table;
+		return table.base;
+	} // seq_complement_table
+
+	struct seq_kernel_scalar {
+		static void upper (char* s, size_t n) {
+			for (size_t i = 0; i < n; ++ i) {
+				if ((unsigned char) (s[i] - 'a') < 26) s[i] -= 0x20;
+			}
+		}
+
+		static size_t encode (const char* s, size_t n, uint8_t* code) {
+			const uint8_t* t = seq_code_table ();
+			size_t other = 0;
+			for (size_t i = 0; i < n; ++ i) {
+				code[i] = t[(unsigned char) s[i]];
+				other += (code[i] == 4);
+			}
+			return other;
+		}
+
+		/* [lo, hi) of [in] into [lo, hi) of [out], from both ends */
+		static void rvc_range (const char* in, size_t lo, size_t hi,
+				char* out, char other) {
+			const char* t = seq_complement_table ();
+			for (; lo < hi; ++ lo, -- hi) {
+				char a = t[(unsigned char) in[lo]], b = t[(unsigned char) in[hi - 1]];
+				out[lo] = b ? b : other;
+				out[hi - 1] = a ? a : other;
+			}
+		}
+
+		static void rvc (const char* in, size_t n, char* out, char other) {
+			rvc_range (in, 0, n, out, other);
+		}
+
+		static void pack (const uint8_t* code, size_t n, uint8_t* packed) {
+			std::memset (packed, 0, (n + 3) / 4);
+			for (size_t i = 0; i < n; ++ i) packed[i / 4] |= code[i] << (2 * (i % 4));
+		}
+
+		static size_t kmers (const uint8_t* code, size_t n, int k,
+				uint64_t* kmer, uint32_t* pos) {
+			const uint64_t mask = (k >= 32) ? ~ (uint64_t) 0 :
+					(((uint64_t) 1 << (2 * k)) - 1);
+			uint64_t fwd = 0;
+			size_t num = 0;
+			int run = 0;
+			for (size_t i = 0; i < n; ++ i) {
+				if (code[i] > 3) {
+					run = 0;
+					continue;
+				}
+				fwd = ((fwd << 2) | code[i]) & mask;
+				if (++ run >= k) {
+					kmer[num] = fwd;
+					pos[num ++] = i + 1 - k;
+				}
+			}
+			return num;
+		}
+	}; // struct seq_kernel_scalar
+
+#if defined (XNY_SEQ_KERNEL_DISPATCH)
+	/**
+	 * A char c is ACGTacgt iff (c | 0x20) is the lower case base of the
+	 * code looked up by its low nibble (A 1, C 3, T 4, G 7); complements
+	 * are looked up the same way and get the case bit of c back.
+	 */
+	struct seq_kernel_ssse3 {
+		__attribute__ ((target ("ssse3")))
+		static __m128i code_of (__m128i x, __m128i& ok) {
+			const __m128i code_lut = _mm_setr_epi8 (4, 0, 4, 1, 3, 4, 4, 2,
+					4, 4, 4, 4, 4, 4, 4, 4);
+			const __m128i char_lut = _mm_setr_epi8 ('a', 'c', 'g', 't', 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0);
+			__m128i c = _mm_shuffle_epi8 (code_lut, _mm_and_si128 (x, _mm_set1_epi8 (0x0f)));
+			ok = _mm_cmpeq_epi8 (_mm_shuffle_epi8 (char_lut, c),
+					_mm_or_si128 (x, _mm_set1_epi8 (0x20)));
+			return c;
+		}
+
+		__attribute__ ((target ("ssse3")))
+		static __m128i rvc_of (__m128i x, __m128i other) {
+			const __m128i comp_lut = _mm_setr_epi8 (0, 'T', 0, 'G', 'A', 0, 0, 'C',
+					0, 0, 0, 0, 0, 0, 0, 0);
+			const __m128i rev = _mm_setr_epi8 (15, 14, 13, 12, 11, 10, 9, 8,
+					7, 6, 5, 4, 3, 2, 1, 0);
+			__m128i ok;
+			code_of (x, ok);
+			__m128i c = _mm_or_si128 (_mm_shuffle_epi8 (comp_lut,
+					_mm_and_si128 (x, _mm_set1_epi8 (0x0f))),
+					_mm_and_si128 (x, _mm_set1_epi8 (0x20)));
+			c = _mm_or_si128 (_mm_and_si128 (ok, c), _mm_andnot_si128 (ok, other));
+			return _mm_shuffle_epi8 (c, rev);
+		}
+
+		__attribute__ ((target ("ssse3")))
+		static void upper (char* s, size_t n) {
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i x = _mm_loadu_si128 ((const __m128i*) (s + i));
+				// 'a'...'z' to -128...-103
+				__m128i t = _mm_sub_epi8 (x, _mm_set1_epi8 ((char) ('a' + 128)));
+				__m128i m = _mm_cmplt_epi8 (t, _mm_set1_epi8 (-128 + 26));
+				x = _mm_sub_epi8 (x, _mm_and_si128 (m, _mm_set1_epi8 (0x20)));
+				_mm_storeu_si128 ((__m128i*) (s + i), x);
+			}
+			seq_kernel_scalar::upper (s + i, n - i);
+		}
+
+		__attribute__ ((target ("ssse3,popcnt")))
+		static size_t encode (const char* s, size_t n, uint8_t* code) {
+			size_t i = 0, other = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i ok, c = code_of (_mm_loadu_si128 ((const __m128i*) (s + i)), ok);
+				c = _mm_or_si128 (_mm_and_si128 (ok, c),
+						_mm_andnot_si128 (ok, _mm_set1_epi8 (4)));
+				_mm_storeu_si128 ((__m128i*) (code + i), c);
+				other += __builtin_popcount (~ _mm_movemask_epi8 (ok) & 0xffff);
+			}
+			return other + seq_kernel_scalar::encode (s + i, n - i, code + i);
+		}
+
+		__attribute__ ((target ("ssse3")))
+		static void rvc (const char* in, size_t n, char* out, char other) {
+			rvc_range (in, 0, n, out, other);
+		}
+
+		__attribute__ ((target ("ssse3")))
+		static void rvc_range (const char* in, size_t lo, size_t hi,
+				char* out, char other) {
+			const __m128i o = _mm_set1_epi8 (other);
+			for (; hi - lo >= 32; lo += 16, hi -= 16) {
+				__m128i a = _mm_loadu_si128 ((const __m128i*) (in + lo));
+				__m128i b = _mm_loadu_si128 ((const __m128i*) (in + hi - 16));
+				_mm_storeu_si128 ((__m128i*) (out + lo), rvc_of (b, o));
+				_mm_storeu_si128 ((__m128i*) (out + hi - 16), rvc_of (a, o));
+			}
+			seq_kernel_scalar::rvc_range (in, lo, hi, out, other);
+		}
+
+		__attribute__ ((target ("ssse3")))
+		static void pack (const uint8_t* code, size_t n, uint8_t* packed) {
+			const __m128i gather = _mm_setr_epi8 (0, 4, 8, 12, -1, -1, -1, -1,
+					-1, -1, -1, -1, -1, -1, -1, -1);
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i x = _mm_loadu_si128 ((const __m128i*) (code + i));
+				x = _mm_maddubs_epi16 (x, _mm_set1_epi16 (0x0401)); // c0 + 4 c1
+				x = _mm_madd_epi16 (x, _mm_set1_epi32 (0x00100001)); // + 16 (c2 + 4 c3)
+				int32_t w = _mm_cvtsi128_si32 (_mm_shuffle_epi8 (x, gather));
+				std::memcpy (packed + i / 4, &w, 4);
+			}
+			seq_kernel_scalar::pack (code + i, n - i, packed + i / 4);
+		}
+	}; // struct seq_kernel_ssse3
+
+	/* seq_kernel_ssse3 on two 128 bit lanes, which also takes the tails */
+	struct seq_kernel_avx2 {
+		__attribute__ ((target ("avx2")))
+		static __m256i code_of (__m256i x, __m256i& ok) {
+			const __m256i code_lut = _mm256_setr_epi8 (4, 0, 4, 1, 3, 4, 4, 2,
+					4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 4, 1, 3, 4, 4, 2,
+					4, 4, 4, 4, 4, 4, 4, 4);
+			const __m256i char_lut = _mm256_setr_epi8 ('a', 'c', 'g', 't', 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0, 'a', 'c', 'g', 't', 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0);
+			__m256i c = _mm256_shuffle_epi8 (code_lut,
+					_mm256_and_si256 (x, _mm256_set1_epi8 (0x0f)));
+			ok = _mm256_cmpeq_epi8 (_mm256_shuffle_epi8 (char_lut, c),
+					_mm256_or_si256 (x, _mm256_set1_epi8 (0x20)));
+			return c;
+		}
+
+		__attribute__ ((target ("avx2")))
+		static __m256i rvc_of (__m256i x, __m256i other) {
+			const __m256i comp_lut = _mm256_setr_epi8 (0, 'T', 0, 'G', 'A', 0, 0, 'C',
+					0, 0, 0, 0, 0, 0, 0, 0, 0, 'T', 0, 'G', 'A', 0, 0, 'C',
+					0, 0, 0, 0, 0, 0, 0, 0);
+			const __m256i rev = _mm256_setr_epi8 (15, 14, 13, 12, 11, 10, 9, 8,
+					7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+					7, 6, 5, 4, 3, 2, 1, 0);
+			__m256i ok;
+			code_of (x, ok);
+			__m256i c = _mm256_or_si256 (_mm256_shuffle_epi8 (comp_lut,
+					_mm256_and_si256 (x, _mm256_set1_epi8 (0x0f))),
+					_mm256_and_si256 (x, _mm256_set1_epi8 (0x20)));
+			c = _mm256_blendv_epi8 (other, c, ok);
+			// reverse within the lanes, then swap the lanes
+			return _mm256_permute4x64_epi64 (_mm256_shuffle_epi8 (c, rev), 0x4e);
+		}
+
+		__attribute__ ((target ("avx2")))
+		static void upper (char* s, size_t n) {
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				__m256i x = _mm256_loadu_si256 ((const __m256i*) (s + i));
+				__m256i t = _mm256_sub_epi8 (x, _mm256_set1_epi8 ((char) ('a' + 128)));
+				__m256i m = _mm256_cmpgt_epi8 (_mm256_set1_epi8 (-128 + 26), t);
+				x = _mm256_sub_epi8 (x, _mm256_and_si256 (m, _mm256_set1_epi8 (0x20)));
+				_mm256_storeu_si256 ((__m256i*) (s + i), x);
+			}
+			seq_kernel_ssse3::upper (s + i, n - i);
+		}
+
+		__attribute__ ((target ("avx2,popcnt")))
+		static size_t encode (const char* s, size_t n, uint8_t* code) {
+			size_t i = 0, other = 0;
+			for (; i + 32 <= n; i += 32) {
+				__m256i ok, c = code_of (_mm256_loadu_si256 ((const __m256i*) (s + i)), ok);
+				c = _mm256_blendv_epi8 (_mm256_set1_epi8 (4), c, ok);
+				_mm256_storeu_si256 ((__m256i*) (code + i), c);
+				other += __builtin_popcount (~ (uint32_t) _mm256_movemask_epi8 (ok));
+			}
+			return other + seq_kernel_ssse3::encode (s + i, n - i, code + i);
+		}
+
+		__attribute__ ((target ("avx2")))
+		static void rvc (const char* in, size_t n, char* out, char other) {
+			const __m256i o = _mm256_set1_epi8 (other);
+			size_t lo = 0, hi = n;
+			for (; hi - lo >= 64; lo += 32, hi -= 32) {
+				__m256i a = _mm256_loadu_si256 ((const __m256i*) (in + lo));
+				__m256i b = _mm256_loadu_si256 ((const __m256i*) (in + hi - 32));
+				_mm256_storeu_si256 ((__m256i*) (out + lo), rvc_of (b, o));
+				_mm256_storeu_si256 ((__m256i*) (out + hi - 32), rvc_of (a, o));
+			}
+			seq_kernel_ssse3::rvc_range (in, lo, hi, out, other);
+		}
+
+		__attribute__ ((target ("avx2")))
+		static void pack (const uint8_t* code, size_t n, uint8_t* packed) {
+			const __m256i gather = _mm256_setr_epi8 (0, 4, 8, 12, -1, -1, -1, -1,
+					-1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1,
+					-1, -1, -1, -1, -1, -1, -1, -1);
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				__m256i x = _mm256_loadu_si256 ((const __m256i*) (code + i));
+				x = _mm256_maddubs_epi16 (x, _mm256_set1_epi16 (0x0401));
+				x = _mm256_madd_epi16 (x, _mm256_set1_epi32 (0x00100001));
+				// bytes of each lane to its low 4, then both to the low 8
+				x = _mm256_permutevar8x32_epi32 (_mm256_shuffle_epi8 (x, gather),
+						_mm256_setr_epi32 (0, 4, 1, 1, 1, 1, 1, 1));
+				_mm_storel_epi64 ((__m128i*) (packed + i / 4), _mm256_castsi256_si128 (x));
+			}
+			seq_kernel_ssse3::pack (code + i, n - i, packed + i / 4);
+		}
+	}; // struct seq_kernel_avx2
+#endif
+
+	/* best instruction set of the CPU */
+	inline seq_isa seq_isa_supported () {
+#if defined (XNY_SEQ_KERNEL_DISPATCH)
+		__builtin_cpu_init ();
+		if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("popcnt")) {
+			return SEQ_AVX2;
+		}
+		if (__builtin_cpu_supports ("ssse3") && __builtin_cpu_supports ("popcnt")) {
+			return SEQ_SSSE3;
+		}
+#endif
+		return SEQ_SCALAR;
+	} // seq_isa_supported
+
+	template <typename impl_t>
+	seq_kernel_t make_seq_kernel (seq_isa isa) {
+		seq_kernel_t k = { &impl_t::upper, &impl_t::encode, &impl_t::rvc,
+			&impl_t::pack, &seq_kernel_scalar::kmers, isa };
+		return k;
+	}
+
+	/** Function: seq_kernel ()
+	 *  Return the kernels of [isa], or of the best instruction set of the
+	 *  CPU below it
+	 */
+	inline seq_kernel_t seq_kernel (seq_isa isa) {
+		seq_isa best = seq_isa_supported ();
+		if (isa > best) isa = best;
+#if defined (XNY_SEQ_KERNEL_DISPATCH)
+		if (isa == SEQ_AVX2) return make_seq_kernel<seq_kernel_avx2> (isa);
+		if (isa == SEQ_SSSE3) return make_seq_kernel<seq_kernel_ssse3> (isa);
+#endif
+		return make_seq_kernel<seq_kernel_scalar> (SEQ_SCALAR);
+	} // seq_kernel
+
+	/* kernels of the best instruction set, selected on first use */
+	inline const seq_kernel_t& seq_kernel () {
+		static const seq_kernel_t k = seq_kernel (SEQ_AVX2);
+		return k;
+	}
+
+	inline void seq_upper (char* s, size_t n) {
+		seq_kernel ().upper (s, n);
+	}
+
+	inline size_t seq_encode (const char* s, size_t n, uint8_t* code) {
+		return seq_kernel ().encode (s, n, code);
+	}
+
+	inline void seq_rvc (const char* in, size_t n, char* out, char other = 'N') {
+		seq_kernel ().rvc (in, n, out, other);
+	}
+
+	inline void seq_pack (const uint8_t* code, size_t n, uint8_t* packed) {
+		seq_kernel ().pack (code, n, packed);
+	}
+
+	/* [kmer] and [pos] hold up to n - k + 1 entries; returns the number
+	 * of k-mers written */
+	inline size_t seq_kmers (const uint8_t* code, size_t n, int k,
+			uint64_t* kmer, uint32_t* pos) {
+		return seq_kernel ().kmers (code, n, k, kmer, pos);
+	}
+
+} // namespace xny
+
+#endif /* SEQ_KERNEL_HPP_ */
@@ -0,0 +1,175 @@
+//============================================================================
+// Name        : seq_kernel_bench.cpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute, 2026
+// Description : Checks the SSSE3 and AVX2 versions of xny/seq_kernel.hpp
+//				 against the scalar one on random input and times them
+//============================================================================
+
+/**
+ * Usage: seq_kernel_bench [num_reads] [read_len]
+ *
+ * Random reads (ACGT in both cases, with N and other chars) of every
+ * length up to 2 * read_len are run through each kernel of every
+ * instruction set the CPU supports; any difference from the scalar
+ * results is reported and makes the exit status 1. Then ns per read of
+ * read_len bases are printed for each kernel and instruction set.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <sys/time.h>
+#include "xny/seq_kernel.hpp"
+
+typedef std::vector<uint8_t> u8vec_t;
+
+static double get_time () {
+	timeval t;
+	gettimeofday (&t, NULL);
+	return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+static std::string random_read (int len) {
+	static const char alphabet[] = "ACGTACGTACGTacgtNn-X";
+	std::string s (len, 'A');
+	for (int i = 0; i < len; ++ i) s[i] = alphabet[rand () % 20];
+	return s;
+}
+
+static const char* isa_name (xny::seq_isa isa) {
+	return isa == xny::SEQ_AVX2 ? "avx2" :
+			(isa == xny::SEQ_SSSE3 ? "ssse3" : "scalar");
+}
+
+/* compare every kernel of [k] to [ref] on [s], return false on a mismatch */
+static bool check (const xny::seq_kernel_t& k, const xny::seq_kernel_t& ref,
+		const std::string& s) {
+	size_t n = s.length();
+	bool ok = true;
+
+	std::string u = s, u_ref = s;
+	k.upper (&u[0], n);
+	ref.upper (&u_ref[0], n);
+	ok = ok && (u == u_ref);
+
+	u8vec_t c (n + 1), c_ref (n + 1);
+	ok = ok && (k.encode (s.data(), n, &c[0]) ==
+			ref.encode (s.data(), n, &c_ref[0]));
+	ok = ok && (c == c_ref);
+
+	std::string r (n, 0), r_ref (n, 0), in_place = s;
+	k.rvc (s.data(), n, &r[0], 'N');
+	ref.rvc (s.data(), n, &r_ref[0], 'N');
+	k.rvc (in_place.data(), n, &in_place[0], 'N');
+	ok = ok && (r == r_ref) && (in_place == r_ref);
+
+	// pack takes codes 0-3 only
+	for (size_t i = 0; i < n; ++ i) c_ref[i] &= 3;
+	u8vec_t p (n / 4 + 1), p_ref (n / 4 + 1);
+	k.pack (&c_ref[0], n, &p[0]);
+	ref.pack (&c_ref[0], n, &p_ref[0]);
+	ok = ok && (p == p_ref);
+
+	std::vector<uint64_t> km (n + 1), km_ref (n + 1);
+	std::vector<uint32_t> pos (n + 1), pos_ref (n + 1);
+	ref.encode (s.data(), n, &c_ref[0]);
+	for (int kk = 1; kk <= 32; kk += 7) {
+		size_t num = k.kmers (&c_ref[0], n, kk, &km[0], &pos[0]),
+			num_ref = ref.kmers (&c_ref[0], n, kk, &km_ref[0], &pos_ref[0]);
+		ok = ok && num == num_ref &&
+			std::equal (km.begin(), km.begin() + num, km_ref.begin()) &&
+			std::equal (pos.begin(), pos.begin() + num, pos_ref.begin());
+	}
+	return ok;
+} // check
+
+int main (int argc, char** argv) {
+	int num_reads = argc > 1 ? atoi (argv[1]) : 100000,
+		read_len = argc > 2 ? atoi (argv[2]) : 150;
+	if (num_reads < 1 || read_len < 1) {
+		std::cout << "Usage: " << argv[0] << " [num_reads] [read_len]\n";
+		return 1;
+	}
+	srand (1);
+
+	xny::seq_isa best = xny::seq_isa_supported ();
+	std::vector<xny::seq_kernel_t> kernels;
+	for (int isa = xny::SEQ_SCALAR; isa <= best; ++ isa) {
+		kernels.push_back (xny::seq_kernel ((xny::seq_isa) isa));
+	}
+	std::cout << "instruction sets: ";
+	for (auto& k: kernels) std::cout << isa_name (k.isa) << " ";
+	std::cout << "\n";
+
+	// ------------------------- check ------------------------------
+	int num_failed = 0;
+	for (int len = 0; len <= 2 * read_len; ++ len) {
+		for (int rep = 0; rep < 20; ++ rep) {
+			std::string s = random_read (len);
+			for (size_t i = 1; i < kernels.size(); ++ i) {
+				if (! check (kernels[i], kernels[0], s)) {
+					if (num_failed ++ < 10) {
+						std::cout << "[FAILED] " << isa_name (kernels[i].isa)
+							<< ": " << s << "\n";
+					}
+				}
+			}
+		}
+	}
+	std::cout << (num_failed ? "check failed\n" : "check passed\n");
+
+	// ------------------------- time -------------------------------
+	std::vector<std::string> reads (num_reads);
+	for (auto& r: reads) r = random_read (read_len);
+	u8vec_t code (read_len), packed (read_len / 4 + 1);
+	std::string out (read_len, 0);
+	std::vector<uint64_t> km (read_len);
+	std::vector<uint32_t> pos (read_len);
+	size_t sink = 0; // keeps the results alive
+
+	std::cout << "ns per read of " << read_len << " bases\n"
+			<< "isa\tupper\tencode\trvc\tpack\tkmers(k=31)\n"
+			<< std::fixed << std::setprecision (1);
+	for (auto& k: kernels) {
+		double t[5];
+		double timing = get_time ();
+		for (auto& r: reads) {
+			out = r;
+			k.upper (&out[0], read_len);
+			sink += out[0];
+		}
+		t[0] = get_time () - timing;
+		timing = get_time ();
+		for (auto& r: reads) sink += k.encode (r.data(), read_len, &code[0]);
+		t[1] = get_time () - timing;
+		timing = get_time ();
+		for (auto& r: reads) {
+			k.rvc (r.data(), read_len, &out[0], 'N');
+			sink += out[0];
+		}
+		t[2] = get_time () - timing;
+		for (auto& c: code) c &= 3;
+		timing = get_time ();
+		for (int i = 0; i < num_reads; ++ i) {
+			k.pack (&code[0], read_len, &packed[0]);
+			sink += packed[0];
+		}
+		t[3] = get_time () - timing;
+		timing = get_time ();
+		for (int i = 0; i < num_reads; ++ i) {
+			sink += k.kmers (&code[0], read_len, 31, &km[0], &pos[0]);
+		}
+		t[4] = get_time () - timing;
+
+		std::cout << isa_name (k.isa);
+		for (int j = 0; j < 5; ++ j) std::cout << "\t" << t[j] * 1e9 / num_reads;
+		std::cout << "\n";
+	}
+	if (sink == 1) std::cout << "\n";
+	return num_failed ? 1 : 0;
+}
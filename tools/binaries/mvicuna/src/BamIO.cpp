@@ -0,0 +1,409 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : BamIO.cpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : BGZF streams and query name grouped BAM
+//				 records for DupRm -drm_ibam/-drm_obam
+//========================================================================
+
+#include <cstring>
+#include <sstream>
+#include "BamIO.h"
+
+namespace {
+	const size_t bgzf_max_block = 0xff00; // uncompressed bytes per block
+	const unsigned char bgzf_eof[28] = { 31, 139, 8, 4, 0, 0, 0, 0, 0, 255,
+		6, 0, 66, 67, 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+	template <typename T>
+	T get_le (const char* p) {
+		T v;
+		memcpy (&v, p, sizeof(T));
+		return v;
+	}
+}
+
+/**	Function bgzf_reader::open ()
+ *
+ */
+void bgzf_reader::open (const std::string& file) {
+	close ();
+	file_ = file;
+	fp_ = fopen (file.c_str(), "rb");
+	if (fp_ == NULL) abording ("bgzf_reader: cannot open " + file);
+	block_.clear ();
+	pos_ = 0;
+} // bgzf_reader::open
+
+void bgzf_reader::close () {
+	if (fp_ != NULL) fclose (fp_);
+	fp_ = NULL;
+}
+
+/**	Function bgzf_reader::read ()
+ *
+ *	Copy the next [n] uncompressed bytes to [buf]; return the number of
+ *	bytes copied, which is less than [n] only at the end of the file
+ */
+size_t bgzf_reader::read (char* buf, size_t n) {
+	size_t cnt = 0;
+	while (cnt < n) {
+		if (pos_ == block_.size() && ! load_block ()) break;
+		size_t len = std::min (n - cnt, block_.size() - pos_);
+		memcpy (buf + cnt, &block_[pos_], len);
+		pos_ += len;
+		cnt += len;
+	}
+	return cnt;
+} // bgzf_reader::read
+
+/**	Function bgzf_reader::load_block ()
+ *
+ *	Inflate the next non-empty BGZF block; return false at the end of file
+ */
+bool bgzf_reader::load_block () {
+	while (true) {
+		char head[12];
+		size_t len = fread (head, 1, 12, fp_);
+		if (len == 0) return false;
+		if (len != 12 || (unsigned char) head[0] != 31 ||
+			(unsigned char) head[1] != 139 || head[2] != 8 || !(head[3] & 4)) {
+			abording ("bgzf_reader: " + file_ + " is not BGZF compressed");
+		}
+		int xlen = get_le<uint16_t> (head + 10);
+		std::string extra (xlen, 0);
+		if ((int) fread (&extra[0], 1, xlen, fp_) != xlen) {
+			abording ("bgzf_reader: truncated block in " + file_);
+		}
+		int bsize = -1;
+		for (int i = 0; i + 4 <= xlen; ) {
+			int slen = get_le<uint16_t> (&extra[i + 2]);
+			if (extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2) {
+				bsize = get_le<uint16_t> (&extra[i + 4]);
+			}
+			i += 4 + slen;
+		}
+		if (bsize < 0) abording ("bgzf_reader: missing BSIZE in " + file_);
+
+		int remain = bsize + 1 - 12 - xlen; // cdata, crc32, isize
+		cdata_.resize (remain);
+		if (remain < 8 || (int) fread (&cdata_[0], 1, remain, fp_) != remain) {
+			abording ("bgzf_reader: truncated block in " + file_);
+		}
+		uint32_t crc = get_le<uint32_t> (&cdata_[remain - 8]),
+				isize = get_le<uint32_t> (&cdata_[remain - 4]);
+		block_.resize (isize);
+		pos_ = 0;
+		if (isize == 0) continue; // empty block, e.g. EOF marker
+
+		z_stream zs;
+		memset (&zs, 0, sizeof(zs));
+		zs.next_in = (Bytef*) &cdata_[0];
+		zs.avail_in = remain - 8;
+		zs.next_out = (Bytef*) &block_[0];
+		zs.avail_out = isize;
+		if (inflateInit2 (&zs, -15) != Z_OK ||
+			inflate (&zs, Z_FINISH) != Z_STREAM_END ||
+			zs.total_out != isize) {
+			abording ("bgzf_reader: corrupted block in " + file_);
+		}
+		inflateEnd (&zs);
+		if (crc32 (crc32 (0L, Z_NULL, 0), (const Bytef*) &block_[0], isize)
+				!= crc) {
+			abording ("bgzf_reader: CRC mismatch in " + file_);
+		}
+		return true;
+	}
+} // bgzf_reader::load_block
+
+/**	Function bgzf_writer::open ()
+ *
+ */
+void bgzf_writer::open (const std::string& file) {
+	close ();
+	file_ = file;
+	fp_ = fopen (file.c_str(), "wb");
+	if (fp_ == NULL) abording ("bgzf_writer: cannot open " + file);
+	block_.clear ();
+} // bgzf_writer::open
+
+/**	Function bgzf_writer::close ()
+ *
+ *	Flush pending data and append the BGZF EOF marker
+ */
+void bgzf_writer::close () {
+	if (fp_ == NULL) return;
+	flush_block ();
+	fwrite (bgzf_eof, 1, sizeof(bgzf_eof), fp_);
+	fclose (fp_);
+	fp_ = NULL;
+} // bgzf_writer::close
+
+void bgzf_writer::write (const char* buf, size_t n) {
+	while (n) {
+		size_t len = std::min (n, bgzf_max_block - block_.size());
+		block_.append (buf, len);
+		buf += len;
+		n -= len;
+		if (block_.size() == bgzf_max_block) flush_block ();
+	}
+} // bgzf_writer::write
+
+/**	Function bgzf_writer::flush_block ()
+ *
+ *	Deflate pending data into one BGZF block
+ */
+void bgzf_writer::flush_block () {
+	if (block_.empty()) return;
+
+	cdata_.resize (65536);
+	z_stream zs;
+	memset (&zs, 0, sizeof(zs));
+	zs.next_in = (Bytef*) &block_[0];
+	zs.avail_in = block_.size();
+	zs.next_out = (Bytef*) &cdata_[18];
+	zs.avail_out = cdata_.size() - 18 - 8;
+	if (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+			Z_DEFAULT_STRATEGY) != Z_OK ||
+		deflate (&zs, Z_FINISH) != Z_STREAM_END) {
+		abording ("bgzf_writer: compression failed for " + file_);
+	}
+	deflateEnd (&zs);
+
+	size_t bsize = 18 + zs.total_out + 8;
+	const unsigned char head[16] = { 31, 139, 8, 4, 0, 0, 0, 0, 0, 255,
+		6, 0, 66, 67, 2, 0 };
+	memcpy (&cdata_[0], head, 16);
+	uint16_t bs = bsize - 1;
+	memcpy (&cdata_[16], &bs, 2);
+	uint32_t crc = crc32 (crc32 (0L, Z_NULL, 0), (const Bytef*) &block_[0],
+			block_.size()), isize = block_.size();
+	memcpy (&cdata_[bsize - 8], &crc, 4);
+	memcpy (&cdata_[bsize - 4], &isize, 4);
+	if (fwrite (&cdata_[0], 1, bsize, fp_) != bsize) {
+		abording ("bgzf_writer: cannot write to " + file_);
+	}
+	block_.clear ();
+} // bgzf_writer::flush_block
+
+/**	Function bam_reader::open ()
+ *
+ *	Read the header and collect the library (LB) of each read group
+ */
+void bam_reader::open (const std::string& file) {
+	bgzf_.open (file);
+	has_pending_ = false;
+	rg2lib_.clear ();
+
+	char buf[4];
+	if (bgzf_.read (buf, 4) != 4 || memcmp (buf, "BAM\1", 4) != 0) {
+		abording ("bam_reader: " + file + " is not a BAM file");
+	}
+	header_.assign (buf, 4);
+
+	// a non-negative little endian int32, appended to the header
+	auto read_len = [&] () -> int32_t {
+		if (bgzf_.read (buf, 4) != 4) {
+			abording ("bam_reader: truncated header in " + file);
+		}
+		header_.append (buf, 4);
+		int32_t v = get_le<int32_t> (buf);
+		if (v < 0) abording ("bam_reader: corrupted header in " + file);
+		return v;
+	};
+
+	int32_t l_text = read_len ();
+	std::string text (l_text, 0);
+	if (l_text && (int32_t) bgzf_.read (&text[0], l_text) != l_text) {
+		abording ("bam_reader: truncated header in " + file);
+	}
+	header_ += text;
+
+	int32_t n_ref = read_len ();
+	for (int i = 0; i < n_ref; ++ i) {
+		std::string ref ((size_t) read_len () + 4, 0); // name, l_ref
+		if (bgzf_.read (&ref[0], ref.size()) != ref.size()) {
+			abording ("bam_reader: truncated header in " + file);
+		}
+		header_ += ref;
+	}
+
+	// ---- @RG ID -> LB ----
+	std::istringstream iss (text);
+	std::string line;
+	while (std::getline (iss, line)) {
+		if (line.compare (0, 4, "@RG\t") != 0) continue;
+		std::string id, lb;
+		strvec_t fields;
+		split ('\t', line, std::back_inserter(fields));
+		for (auto& f: fields) {
+			if (f.compare (0, 3, "ID:") == 0) id = f.substr (3);
+			else if (f.compare (0, 3, "LB:") == 0) lb = f.substr (3);
+		}
+		rg2lib_[id] = lb.empty() ? id : lb;
+	}
+} // bam_reader::open
+
+/**	Function bam_reader::next ()
+ *
+ *	Read the next record; return false at the end of the file
+ */
+bool bam_reader::next (std::string& rec) {
+	if (has_pending_) {
+		rec.swap (pending_);
+		has_pending_ = false;
+		return true;
+	}
+	char buf[4];
+	size_t len = bgzf_.read (buf, 4);
+	if (len == 0) return false;
+	int32_t block_size = get_le<int32_t> (buf);
+	if (len != 4 || block_size < 32) abording ("bam_reader: corrupted record");
+	rec.resize (block_size);
+	if ((int32_t) bgzf_.read (&rec[0], block_size) != block_size) {
+		abording ("bam_reader: truncated record");
+	}
+	// read name, cigar, seq and qual have to fit in the record
+	int l_name = (unsigned char) rec[8];
+	int64_t n_cigar = get_le<uint16_t> (rec.data() + 12),
+		l_seq = get_le<int32_t> (rec.data() + 16);
+	if (l_name < 1 || l_seq < 0 ||
+		32 + l_name + 4 * n_cigar + (l_seq + 1)/2 + l_seq > block_size) {
+		abording ("bam_reader: corrupted record");
+	}
+	return true;
+} // bam_reader::next
+
+/**	Function bam_reader::next_group ()
+ *
+ *	Read consecutive records sharing the same read name into [recs];
+ *	requires a query name grouped BAM. Return false at the end of the file
+ */
+bool bam_reader::next_group (strvec_t& recs) {
+	recs.clear ();
+	std::string rec;
+	if (! next (rec)) return false;
+	std::string name = bam_name (rec);
+	recs.push_back (rec);
+	while (next (rec)) {
+		if (bam_name (rec) != name) {
+			pending_.swap (rec);
+			has_pending_ = true;
+			break;
+		}
+		recs.push_back (rec);
+	}
+	return true;
+} // bam_reader::next_group
+
+/**	Function bam_reader::library ()
+ *
+ *	Library of read group [rg]; the read group itself if it has no LB
+ */
+std::string bam_reader::library (const std::string& rg) const {
+	std::map<std::string, std::string>::const_iterator it = rg2lib_.find (rg);
+	return it == rg2lib_.end() ? rg : it->second;
+} // bam_reader::library
+
+void bam_writer::open (const std::string& file, const std::string& header) {
+	bgzf_.open (file);
+	bgzf_.write (header.data(), header.size());
+}
+
+void bam_writer::write (const std::string& rec) {
+	int32_t block_size = rec.size();
+	bgzf_.write ((const char*) &block_size, 4);
+	bgzf_.write (rec.data(), rec.size());
+}
+
+/* fixed fields of a record without block_size, see SAM spec 4.2 */
+std::string bam_name (const std::string& rec) {
+	return std::string (rec.data() + 32, (unsigned char) rec[8] - 1);
+}
+
+int bam_flag (const std::string& rec) {
+	return get_le<uint16_t> (rec.data() + 14);
+}
+
+/**	Function bam_seq ()
+ *
+ *	Decode the read sequence, reverse complemented back to the sequenced
+ *	strand if the record is flagged as reverse
+ */
+std::string bam_seq (const std::string& rec) {
+	static const char code[] = "=ACMGRSVTWYHKDBN";
+	int l_name = (unsigned char) rec[8];
+	int n_cigar = get_le<uint16_t> (rec.data() + 12);
+	int l_seq = get_le<int32_t> (rec.data() + 16);
+	const char* p = rec.data() + 32 + l_name + 4 * n_cigar;
+	std::string seq (l_seq, 'N');
+	for (int i = 0; i < l_seq; ++ i) {
+		unsigned char b = p[i/2];
+		seq[i] = code[(i % 2) ? (b & 0xf) : (b >> 4)];
+	}
+	if (bam_flag (rec) & BAM_REVERSE) {
+		std::reverse (seq.begin(), seq.end());
+		for (auto& c: seq) {
+			switch (c) {
+			case 'A': c = 'T'; break;
+			case 'C': c = 'G'; break;
+			case 'G': c = 'C'; break;
+			case 'T': c = 'A'; break;
+			default: c = 'N';
+			}
+		}
+	}
+	return seq;
+} // bam_seq
+
+/**	Function bam_tag_z ()
+ *
+ *	Value of the string (Z) aux field [tag]; empty if absent
+ */
+std::string bam_tag_z (const std::string& rec, const char* tag) {
+	int l_name = (unsigned char) rec[8];
+	int n_cigar = get_le<uint16_t> (rec.data() + 12);
+	int l_seq = get_le<int32_t> (rec.data() + 16);
+	size_t i = 32 + l_name + 4 * n_cigar + (l_seq + 1)/2 + l_seq;
+	while (i + 3 <= rec.size()) {
+		bool match = rec[i] == tag[0] && rec[i + 1] == tag[1];
+		char type = rec[i + 2];
+		i += 3;
+		size_t sz = 0;
+		switch (type) {
+		case 'A': case 'c': case 'C': sz = 1; break;
+		case 's': case 'S': sz = 2; break;
+		case 'i': case 'I': case 'f': sz = 4; break;
+		case 'Z': case 'H': {
+			size_t end = rec.find ('\0', i);
+			if (end == std::string::npos) return "";
+			if (match && type == 'Z') return rec.substr (i, end - i);
+			sz = end - i + 1;
+			break;
+		}
+		case 'B': {
+			if (i + 5 > rec.size()) return "";
+			char sub = rec[i];
+			int32_t n = get_le<int32_t> (rec.data() + i + 1);
+			int esz = (sub == 'c' || sub == 'C') ? 1 :
+					(sub == 's' || sub == 'S') ? 2 : 4;
+			sz = 5 + (size_t) n * esz;
+			break;
+		}
+		default:
+			return ""; // unknown type, stop parsing
+		}
+		i += sz;
+	}
+	return "";
+} // bam_tag_z
@@ -0,0 +1,101 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : BamIO.h
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : minimal BGZF/BAM reader and writer (SAM spec v1), records
+//				 are kept as raw byte strings so that they can be written
+//				 back unchanged. Assumes a little endian host.
+//========================================================================
+
+
+#ifndef BAMIO_H_
+#define BAMIO_H_
+
+#include <cstdio>
+#include <zlib.h>
+#include "xutil.h"
+
+/* BAM flags used by mvicuna */
+enum BamFlag { BAM_REVERSE = 0x10, BAM_READ1 = 0x40, BAM_READ2 = 0x80,
+	BAM_SECONDARY = 0x100, BAM_SUPPLEMENTARY = 0x800 };
+
+/* BGZF (blocked gzip) input stream */
+class bgzf_reader {
+public:
+	bgzf_reader (): fp_(NULL), pos_(0) {}
+	~bgzf_reader () { close (); }
+	void open (const std::string& file);
+	void close ();
+	size_t read (char* buf, size_t n);
+private:
+	FILE* fp_;
+	std::string file_;
+	std::string block_; // uncompressed current block
+	size_t pos_;
+	std::string cdata_;
+	bool load_block ();
+};
+
+/* BGZF (blocked gzip) output stream */
+class bgzf_writer {
+public:
+	bgzf_writer (): fp_(NULL) {}
+	~bgzf_writer () { close (); }
+	void open (const std::string& file);
+	void close ();
+	void write (const char* buf, size_t n);
+private:
+	FILE* fp_;
+	std::string file_;
+	std::string block_; // uncompressed pending data
+	std::string cdata_;
+	void flush_block ();
+};
+
+/* BAM input; records are returned without their block_size field */
+class bam_reader {
+public:
+	bam_reader (): has_pending_(false) {}
+	void open (const std::string& file);
+	void close () { bgzf_.close (); }
+	bool next (std::string& rec);
+	bool next_group (strvec_t& recs);
+	const std::string& header () const { return header_; }
+	std::string library (const std::string& rg) const;
+private:
+	bgzf_reader bgzf_;
+	std::string header_; // raw header, from magic to the reference list
+	std::map<std::string, std::string> rg2lib_;
+	std::string pending_; // look ahead record of next_group ()
+	bool has_pending_;
+};
+
+/* BAM output of raw records */
+class bam_writer {
+public:
+	void open (const std::string& file, const std::string& header);
+	void close () { bgzf_.close (); }
+	void write (const std::string& rec);
+private:
+	bgzf_writer bgzf_;
+};
+
+std::string bam_name (const std::string& rec);
+
+int bam_flag (const std::string& rec);
+
+std::string bam_seq (const std::string& rec);
+
+std::string bam_tag_z (const std::string& rec, const char* tag);
+
+#endif /* BAMIO_H_ */
@@ -29,9 +29,15 @@
  * result in reads containing a small number of Ns being considered for
  * clustering whereas reads containing a lot of Ns will not be considered
  * anyway.
+ *
+ * If UMIs are provided, fragments are first partitioned by UMI and only
+ * fragments within the same partition are compared.
+ *
+ * If drm.stream is set, every input pair is instead processed in a single
+ * pass using a signature filter of [mem] MB, see stream_dupl_frag ().
  */
 void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
-		int w2, xny::low_complexity& lc, int batch, bool silent) {
+		int w2, xny::low_complexity& lc, int batch, int mem, bool silent) {
 
 
 	// sanity check
@@ -39,36 +45,30 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 		abording ("duplicate_removal ofqs.size() != ifqs.size() and"
 				"ofqs.size() != 2");
 	}
-	// first obtain the length of a read, double it to be fragment length
-	std::ifstream fh_tmp;
-	xny::openfile<std::ifstream>(fh_tmp, ifqs[0]);
-	bio::fastq_input_iterator<> fq(fh_tmp);
-	int frag_len = 2 * (std::get<1>(*fq)).length();
-	xny::closefile(fh_tmp);
-
-	// calculate the upper bound of mismatches can be tolerated,
-	// number of seeds & seed length; max seed length will be bounded by 31
-//	int ub_mismatch = std::min (drm.max_mismatch, frag_len * (100 - drm.perc_sim) /100),
-	int ub_mismatch = frag_len * (100 - drm.perc_sim) /100,
-		//num_seed = ub_mismatch + 1,
-		seed_len = std::min(frag_len / (ub_mismatch + 1), 31);
-		//num_seed = std::max(num_seed, frag_len/seed_len);
+	if (drm.umi_fq.size() && (drm.umi_fq.size() != ifqs.size()/2)) {
+		abording ("duplicate_removal: one UMI fq file is required per "
+				"input pair");
+	}
+	bool use_umi = drm.umi_in_name || drm.umi_fq.size();
 
-	//std::cout << max_mismatch << ", " << frag_len << ", " << perc_sim << "\n";
-	//std::cout << "ub_mismatch = " << ub_mismatch << "\n";
+	int frag_len, ub_mismatch, seed_len;
+	get_seed_len (frag_len, ub_mismatch, seed_len, ifqs[0], drm.perc_sim);
 
 	// process every pair of files
 	int num_file_pairs = ifqs.size()/2;
 
-	xny::sketch_list slistgen (w, false);
-	xny::super_sketch ssgen (w2);
-
 	std::ofstream ofhfq, ofhfq2;
 	if (drm.op.size() == 2) {
 		xny::openfile<std::ofstream> (ofhfq, drm.op[0]);
 		xny::openfile<std::ofstream> (ofhfq2, drm.op[1]);
 	}
 
+	std::ofstream ofhstats;
+	if (drm.stats.size()) {
+		xny::openfile<std::ofstream> (ofhstats, drm.stats);
+		ofhstats << "{\n\"file_pairs\": [";
+	}
+
 	for (int i = 0; i < num_file_pairs; ++ i) {
 
 		int fID = 2*i;
@@ -78,13 +78,45 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 					<< ifqs[fID + 1] << "\n\n";
 		}
 
-		// --------------- generate seeds for each fragment -------------
+		// ------------- single pass approximate duplicate removal --------
+		if (drm.stream) {
+			if (drm.op.size() > 2) {
+				xny::openfile<std::ofstream> (ofhfq, drm.op[fID]);
+				xny::openfile<std::ofstream> (ofhfq2, drm.op[fID + 1]);
+			}
+
+			stream_dupl_frag (ifqs[fID], ifqs[fID + 1], ofhfq, ofhfq2, drm,
+				w, w2, lc, batch, mem, silent);
+
+			if (drm.op.size() > 2) {
+				xny::closefile(ofhfq);
+				xny::closefile(ofhfq2);
+			}
+			continue;
+		}
+
+		// ------ generate seeds, super sketches and lc flags ----------
 		// ----------- a compressed form to represent fragments ---------
-		if (! silent) std::cout << "\tgenerate seeds...\n";
+		if (! silent) std::cout << "\tgenerate seeds and super sketches...\n";
 		ii64vec_t list_seeds; // stores the list of seeds per fragment,
 							  // the last element stores the fragment ID
-		get_seeds (list_seeds, ifqs[fID], ifqs[fID + 1], seed_len,
-				batch, silent);
+		std::vector<sketch_t> super_sketches;
+		bvec_t is_lc;
+		jaz::murmur264 hashfunc (rand() % RAND_MAX);
+		get_encoded_fragments (list_seeds, super_sketches, is_lc, ifqs[fID],
+				ifqs[fID + 1], seed_len, w, w2, hashfunc, lc, batch, silent);
+
+		// ------- partition fragments by UMI when applicable ---------
+		ivec_t frag_part; // fragID -> UMI partition ID; empty if no UMI
+		if (use_umi) {
+			if (! silent) std::cout << "\tpartition fragments by UMI...\n";
+			get_umi_partitions (frag_part, ifqs[fID],
+				drm.umi_fq.size() ? drm.umi_fq[i] : "", drm, batch, silent);
+			if (frag_part.size() != list_seeds.size()) {
+				abording ("duplicate_removal: number of UMIs differs from "
+						"number of fragments");
+			}
+		}
 
 		// ---- initialize the global union-find structure ----
 		ivec_t uf_clst (list_seeds.size());
@@ -94,13 +126,19 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 
 		if (! silent) std::cout << "\tclustering via super sketches ...\n";
 
-		clustering_via_ss (uf_clst, list_seeds, ifqs[fID], ifqs[fID + 1],
-				batch, slistgen, ssgen, ub_mismatch, silent);
+		cls_stats_vec_t stats;
+		int num_ss_dupl = clustering_via_ss (uf_clst, list_seeds, frag_part,
+				super_sketches, ub_mismatch, stats, silent);
+		super_sketches.clear();
+		if (!silent) {
+			std::cout << "\n\t\t\tduplicates: " << num_ss_dupl << "\n";
+		}
 
 		// --------------- clustering via seeds -----------------
 		if (!silent) std::cout << "\tclustering via seeds ...\n";
-		clustering_via_seeds (uf_clst, list_seeds, frag_len/seed_len,
-				ub_mismatch, silent);
+		clustering_via_seeds (uf_clst, list_seeds, frag_part,
+				frag_len/seed_len, ub_mismatch, drm.max_seed_frq, stats,
+				silent);
 
 
 		// -------- generate final union find clusters --------------
@@ -126,6 +164,11 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 		if (!silent) std::cout << "\n\t\tnum duplicate frags: " << duplIDs.size()
 				<< "(" << 100 * duplIDs.size()/ list_seeds.size() << "% total)" << "\n\n";
 
+		if (ofhstats.is_open()) {
+			write_cls_stats (ofhstats, ifqs[fID], ifqs[fID + 1],
+				list_seeds.size(), duplIDs.size(), stats, i == 0);
+		}
+
 		if (!silent) std::cout << "\toutput non-redundant read-pairs...\n";
 
 		// ----- output non-redundant read-pairs ---------
@@ -136,7 +179,7 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 		}
 
 		clean_dupl_frag (ifqs[fID], ifqs[fID+1], ofhfq, ofhfq2,
-				 duplIDs, lc, batch);
+				 duplIDs, is_lc, batch);
 
 		if (drm.op.size() > 2) {
 			xny::closefile(ofhfq);
@@ -145,180 +188,750 @@ void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
 
 	} // for (int i = 0
 
+	if (ofhstats.is_open()) {
+		ofhstats << "\n]\n}\n";
+		xny::closefile(ofhstats);
+	}
+
 } // duplicate_removal
 
-/** Function debug_print_fragments ()
- * Given fragment IDs then print concatenated fragments from input fastq files
+/** Function json_str ()
+ *
+ * [s] as a quoted JSON string: quotes, backslashes and control chars are
+ * escaped
  */
-void debug_print_fragments (const ivec_t& fragIDs, const std::string& fq,
-		const std::string& fq2) {
-
-	std::cout << "\nnum fragments: " << fragIDs.size() << "\n";
-	iset_t ids (fragIDs.begin(), fragIDs.end());
-	std::ifstream ifhfq, ifhfq2;
-	xny::openfile<std::ifstream>(ifhfq, fq);
-	xny::openfile<std::ifstream>(ifhfq2, fq2);
-	bio::fastq_input_iterator<> iter_fq (ifhfq), end, iter_fq2(ifhfq2);
-	int fragID = 0;
-	for (; iter_fq != end, iter_fq2 != end; ++ iter_fq, ++ iter_fq2) {
-		if (ids.count(fragID)) {
-			std::string frag = std::get<1>(*iter_fq) + std::get<1> (*iter_fq2);
-			std::cout << frag << "\n";
+std::string json_str (const std::string& s) {
+	std::string out = "\"";
+	for (int i = 0; i < (int) s.length(); ++ i) {
+		unsigned char c = s[i];
+		switch (c) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if (c < 0x20) {
+				char buf[8];
+				snprintf (buf, sizeof (buf), "\\u%04x", c);
+				out += buf;
+			} else out += c;
 		}
-		++ fragID;
 	}
-	xny::closefile(ifhfq);
-	xny::closefile(ifhfq2);
-} //debug_print_fragments
+	return out + "\"";
+} // json_str
 
-/**	Function clustering_via_ss
+/** Function write_cls_stats ()
  *
- *	Input 1) fragments in binary representation [list_seeds]
- *		  2) super_sketches for each fragment
+ * Write the clustering diagnostics [stats] of input pair [f] and [f2] as an
+ * element of the JSON array "file_pairs"; [first] omits the separator
  */
-void clustering_via_ss (ivec_t& uf_clst, const ii64vec_t& list_seeds,
-	const std::string& f, const std::string& f2, int batch,
-	xny::sketch_list& slistgen, xny::super_sketch& ssgen, int max_mismatch,
-	bool silent) {
+void write_cls_stats (std::ofstream& oh, const std::string& f,
+	const std::string& f2, int num_frags, int num_dupl,
+	const cls_stats_vec_t& stats, bool first) {
+
+	oh << (first ? "\n" : ",\n") << "{\"input\": [" << json_str (f) << ", "
+	   << json_str (f2) << "], \"fragments\": " << num_frags << ", \"duplicates\": "
+	   << num_dupl << ",\n \"rounds\": [";
+	for (int r = 0; r < (int) stats.size(); ++ r) {
+		const cls_stats_t& st = stats[r];
+		oh << (r ? ",\n" : "\n") << "  {\"round\": " << json_str (st.round)
+		   << ", \"seconds\": " << st.seconds
+		   << ", \"buckets\": " << st.num_buckets
+		   << ", \"max_bucket\": " << st.max_bucket
+		   << ", \"capped_buckets\": " << st.num_capped
+		   << ", \"masked_buckets\": " << st.num_masked
+		   << ", \"is_similar_calls\": " << st.num_cmp
+		   << ", \"is_similar_hits\": " << st.num_similar
+		   << ", \"hit_rate\": "
+		   << (st.num_cmp ? (double) st.num_similar / st.num_cmp : 0)
+		   << ", \"unions\": " << st.num_unions
+		   << ",\n   \"bucket_size_log2_hist\": [";
+		for (int b = 0; b < (int) st.bucket_hist.size(); ++ b) {
+			oh << (b ? ", " : "") << st.bucket_hist[b];
+		}
+		oh << "]}";
+	}
+	oh << "\n ]}";
+} // write_cls_stats
 
-	int sz = list_seeds.size();
-	if (sz == 0) return;
+/** Function get_bam_fragment ()
+ *
+ * Index of the first mate-1 and mate-2 primary records in [recs] sharing a
+ * read name; return false if the group is not a read pair
+ */
+bool get_bam_fragment (int& r1, int& r2, const strvec_t& recs) {
+	r1 = r2 = -1;
+	for (int j = 0; j < (int) recs.size(); ++ j) {
+		int flag = bam_flag (recs[j]);
+		if (flag & (BAM_SECONDARY | BAM_SUPPLEMENTARY)) continue;
+		if ((flag & BAM_READ1) && r1 == -1) r1 = j;
+		else if ((flag & BAM_READ2) && r2 == -1) r2 = j;
+	}
+	return r1 != -1 && r2 != -1;
+} // get_bam_fragment
 
-	// ------- multiple iterations of sketching ------------------
+/** Function duplicate_removal_bam ()
+ *
+ * Duplicate removal of a query name grouped unaligned BAM [drm.ibam].
+ * Pass 1 decodes read pairs (records of the same name flagged as mate 1
+ * and mate 2) batch by batch into seeds, super sketches and low
+ * complexity flags, so that no sequence is kept in memory; fragments are
+ * partitioned by library (LB of the RG tag, or the RG itself). Clustering
+ * is identical to duplicate_removal (). Pass 2 copies the raw records of
+ * every kept name group, with all tags and read groups, to [drm.obam];
+ * records that are not part of a read pair are always kept.
+ */
+void duplicate_removal_bam (const drm_t& drm, int w, int w2,
+		xny::low_complexity& lc, int batch, bool silent) {
+
+	jaz::murmur264 hashfunc (rand() % RAND_MAX);
+
+	if (! silent) std::cout << "\tprocess BAM file: " << drm.ibam << "\n\n";
+
+	// ----- pass 1: seeds, super sketches and lc flags of every fragment ---
+	if (! silent) std::cout << "\tgenerate seeds and super sketches...\n";
+	bam_reader ibam;
+	ibam.open (drm.ibam);
+
+	int frag_len = 0, ub_mismatch = 0, seed_len = 0;
+	ii64vec_t list_seeds;
+	std::vector<sketch_t> super_sketches;
+	bvec_t is_lc;
+	ivec_t frag_part;
+	std::map<std::string, int> lib2part;
+	int num_groups = 0;
+
+	strvec_t recs, reads, reads2;
+	ivec_t batch_part;
+	bool more = true;
+	while (more) {
+		more = ibam.next_group (recs);
+		if (more) {
+			++ num_groups;
+			int r1, r2;
+			if (get_bam_fragment (r1, r2, recs)) {
+				reads.push_back (bam_seq (recs[r1]));
+				reads2.push_back (bam_seq (recs[r2]));
+				std::string lib = ibam.library (bam_tag_z (recs[r1], "RG"));
+				std::map<std::string, int>::iterator it = lib2part.find (lib);
+				if (it == lib2part.end()) {
+					it = lib2part.insert (std::make_pair (lib,
+							(int) lib2part.size())).first;
+				}
+				batch_part.push_back (it->second);
+			}
+		}
+		if (reads.size() == 0 || (more && (int) reads.size() < batch/2)) {
+			continue;
+		}
 
-	int pre_sz = 1, iter = 0;
+		if (seed_len == 0) {
+			get_seed_len (frag_len, ub_mismatch, seed_len, reads[0].length(),
+					drm.perc_sim);
+		}
+		reads.insert (reads.end(), reads2.begin(), reads2.end());
+		encode_fragments (list_seeds, super_sketches, is_lc, reads, seed_len,
+				w, w2, hashfunc, lc);
+		frag_part.insert (frag_part.end(), batch_part.begin(),
+				batch_part.end());
+		reads.clear();
+		reads2.clear();
+		batch_part.clear();
+	}
+	ibam.close ();
 
-	while (true) {
+	int num_frags = list_seeds.size();
+	if (lib2part.size() <= 1) frag_part.clear();
+	if (! silent) {
+		std::cout << "\t\trecord groups, read pairs, libraries: " << num_groups
+			<< ", " << num_frags << ", " << lib2part.size() << "\n";
+	}
 
-		if (! silent) std::cout << "\n\t\tsketching iteration: " << iter << "\n";
-		++ iter;
+	// ---- clustering ----
+	iset_t duplIDs;
+	cls_stats_vec_t stats;
+	if (num_frags) {
+		ivec_t uf_clst (num_frags);
+		for (int j = 0; j < num_frags; ++ j) uf_clst[j] = j;
 
-		jaz::murmur264 hashfunc (rand() % RAND_MAX);
+		if (! silent) std::cout << "\tclustering via super sketches ...\n";
+		int num_dupl = clustering_via_ss (uf_clst, list_seeds, frag_part,
+				super_sketches, ub_mismatch, stats, silent);
+		super_sketches.clear();
+		if (!silent) {
+			std::cout << "\n\t\t\tduplicates: " << num_dupl << "\n";
+			std::cout << "\tclustering via seeds ...\n";
+		}
+		clustering_via_seeds (uf_clst, list_seeds, frag_part,
+				frag_len/seed_len, ub_mismatch, drm.max_seed_frq, stats,
+				silent);
 
-		// -----------------------  sketching ---------------------------
-		if (! silent) std::cout << "\t\t\tgenerate super sketches ...\n";
-		std::vector<sketch_t> super_sketches;
-		get_super_sketches (super_sketches, f, f2, slistgen, ssgen,
-				hashfunc, batch, silent);
-		std::sort(super_sketches.begin(), super_sketches.end(),
-					xny::cmp_sketch());
+		iivec_t clusters;
+		uf_generate_cls (clusters, uf_clst);
+		for (int j = 0; j < (int) clusters.size(); ++ j) {
+			duplIDs.insert(clusters[j].begin() + 1, clusters[j].end());
+		}
+	}
+	list_seeds.clear();
 
-		if (sz != list_seeds.size()) abording ("clusetring_via_ss SC failed.");
+	if (!silent) {
+		std::cout << "\n\t\tnum duplicate frags: " << duplIDs.size() << "("
+			<< (num_frags ? 100 * duplIDs.size()/ num_frags : 0)
+			<< "% total)" << "\n\n";
+	}
 
+	if (drm.stats.size()) {
+		std::ofstream ofhstats;
+		xny::openfile<std::ofstream> (ofhstats, drm.stats);
+		ofhstats << "{\n\"file_pairs\": [";
+		write_cls_stats (ofhstats, drm.ibam, drm.obam, num_frags,
+				duplIDs.size(), stats, true);
+		ofhstats << "\n]\n}\n";
+		xny::closefile(ofhstats);
+	}
 
-		// In [init_clusters], each 1d elem stores the indices of
-		// [list_seeds] that share the same super sketch, where in [list_seeds],
-		// the index i should be equal to fragID
-		iivec_t init_clusters (1, ivec_t{super_sketches[0].second});
-		for (int i = 1; i < sz; ++ i) {
-			if (super_sketches[i].first == super_sketches[i-1].first) {
-				init_clusters.rbegin()->push_back(super_sketches[i].second);
-			} else init_clusters.push_back({super_sketches[i].second});
+	// ----- pass 2: copy the records of kept groups ------
+	if (!silent) std::cout << "\toutput non-redundant records...\n";
+	ibam.open (drm.ibam);
+	bam_writer obam;
+	obam.open (drm.obam, ibam.header());
+	int fragID = 0, num_lc = 0;
+	while (ibam.next_group (recs)) {
+		int r1, r2;
+		if (get_bam_fragment (r1, r2, recs)) {
+			if (fragID >= num_frags) {
+				abording ("duplicate_removal_bam: " + drm.ibam + " changed between passes");
+			}
+			bool keep = ! duplIDs.count (fragID) && ! is_lc[fragID];
+			if (is_lc[fragID]) ++ num_lc;
+			++ fragID;
+			if (! keep) continue;
 		}
+		for (auto& rec: recs) obam.write (rec);
+	}
+	ibam.close ();
+	obam.close ();
+	if (fragID != num_frags) {
+		abording ("duplicate_removal_bam: " + drm.ibam + " changed between passes");
+	}
+	if (!silent) std::cout << "\t\tlow complexity fragments: " << num_lc << "\n\n";
 
-		int init_sz = init_clusters.size();
+} // duplicate_removal_bam
 
-		if (!silent){
-			std::cout << "\t\t\t" << init_sz << " clusters to validate\n";
-		}
+/** Function get_seed_len ()
+ *
+ * Obtain the length of a read in [fq], double it to be fragment length,
+ * then calculate the upper bound of mismatches can be tolerated and the
+ * seed length; max seed length will be bounded by 31
+ */
+void get_seed_len (int& frag_len, int& ub_mismatch, int& seed_len,
+		const std::string& fq, int perc_sim) {
+	std::ifstream fh_tmp;
+	xny::openfile<std::ifstream>(fh_tmp, fq);
+	bio::fastq_input_iterator<> iter_fq(fh_tmp);
+	int read_len = (std::get<1>(*iter_fq)).length();
+	xny::closefile(fh_tmp);
 
-		validate_clusters (uf_clst, init_clusters, list_seeds, max_mismatch,
-				INT_MAX);
+	get_seed_len (frag_len, ub_mismatch, seed_len, read_len, perc_sim);
+} // get_seed_len
 
-		// ---- generate final union find clusters ------
-		iivec_t clusters;
-		uf_generate_cls (clusters, uf_clst);
+void get_seed_len (int& frag_len, int& ub_mismatch, int& seed_len,
+		int read_len, int perc_sim) {
+	frag_len = 2 * read_len;
 
-		// ---- generate the duplicated fragment IDs ----------------
-		// iteration ending criteria % duplicate ID increase < 5%
-		iset_t duplIDs;
-		for (int i = 0; i < (int) clusters.size(); ++ i) {
-			duplIDs.insert(clusters[i].begin() + 1, clusters[i].end());
-		}
-		int perc_incr = 100 * (duplIDs.size() - pre_sz)/pre_sz;
-		if (!silent){
-			std::cout << "\n\t\t\tduplicates: " << duplIDs.size() << " (" <<
-					perc_incr << " % increase)\n" ;
+//	int ub_mismatch = std::min (drm.max_mismatch, frag_len * (100 - drm.perc_sim) /100),
+	ub_mismatch = frag_len * (100 - perc_sim) /100;
+		//num_seed = ub_mismatch + 1,
+	seed_len = std::min(frag_len / (ub_mismatch + 1), 31);
+		//num_seed = std::max(num_seed, frag_len/seed_len);
+} // get_seed_len
+
+/** Function estimate_dupl_rate ()
+ *
+ * For each pair of input fq files, draw a uniform sample of [sample_sz]
+ * pairs that are not of low complexity and cluster it with the seed clustering of duplicate_removal ().
+ * The number of distinct fragments in the sample gives the library
+ * complexity under the Lander-Waterman model, from which the expected
+ * duplicate fraction of the full library is extrapolated. A 95% confidence
+ * interval is derived from the binomial error of the sampled distinct
+ * fraction.
+ */
+void estimate_dupl_rate (const strvec_t& ifqs, const drm_t& drm,
+		xny::low_complexity& lc, int sample_sz, int batch, bool silent) {
+
+	int frag_len, ub_mismatch, seed_len;
+	get_seed_len (frag_len, ub_mismatch, seed_len, ifqs[0], drm.perc_sim);
+
+	int num_file_pairs = ifqs.size()/2;
+	for (int i = 0; i < num_file_pairs; ++ i) {
+
+		int fID = 2*i;
+
+		if (! silent) {
+			std::cout << "\tprocess files: " << ifqs[fID] << " and "
+					<< ifqs[fID + 1] << "\n\n";
 		}
-		if (perc_incr < 5) break;
-		else pre_sz = duplIDs.size();
 
-		break;
-	}// 	while (true)
+		strvec_t sample;
+		int total = sample_pairs (sample, ifqs[fID], ifqs[fID + 1], lc,
+				sample_sz, batch);
+		int n = sample.size()/2;
+		if (n == 0) continue;
+
+		ii64vec_t list_seeds;
+		generate_seeds (list_seeds, sample, seed_len);
+		sample.clear();
+
+		ivec_t uf_clst (n);
+		for (int j = 0; j < n; ++ j) uf_clst[j] = j;
+		cls_stats_vec_t stats;
+		clustering_via_seeds (uf_clst, list_seeds, ivec_t(),
+				frag_len/seed_len, ub_mismatch, drm.max_seed_frq, stats, true);
+
+		int c = 0; // distinct fragments in the sample
+		for (int j = 0; j < n; ++ j) if (uf_clst[j] == j) ++ c;
+
+		// distinct fraction of the sample and its 95% confidence interval
+		double p = (double) c / n, se = std::sqrt (p * (1 - p) / n);
+		double p_bounds[3] = { p, std::max (1.0 / n, p - 1.96 * se),
+								std::min (1.0, p + 1.96 * se) };
+		double dupl[3], libsz[3];
+		for (int b = 0; b < 3; ++ b) {
+			libsz[b] = estimate_library_size (n, p_bounds[b] * n);
+			if (n == total) dupl[b] = 1 - p; // the sample is the library
+			else if (libsz[b] < 0) dupl[b] = 0;
+			else dupl[b] = 1 - libsz[b] * (1 - std::exp(- total/libsz[b]))/total;
+		}
 
-} //
+		std::cout << "\t\tpairs sampled: " << n << " of " << total
+				<< " (low complexity excluded)\n";
+		std::cout << "\t\tdistinct fragments in sample: " << c << " ("
+				<< 100 * (1 - p) << "% duplicates)\n";
+		if (libsz[0] < 0) {
+			std::cout << "\t\testimated library size: > " << total
+					<< " (no duplicates sampled)\n";
+		} else {
+			std::cout << "\t\testimated library size: " << (int64_t) libsz[0]
+					<< "\n";
+		}
+		std::cout << "\t\texpected duplicate fraction: " << 100 * dupl[0]
+				<< "% (95% CI " << 100 * dupl[2] << "% - " << 100 * dupl[1]
+				<< "%)\n\n";
+	} // for (int i = 0
+} // estimate_dupl_rate
 
-/**	Function get_super_sketches
+/** Function sample_pairs ()
  *
+ * Reservoir sampling of [sample_sz] read pairs from fq files [f], [f2],
+ * skipping low complexity fragments, which are removed regardless.
+ * [sample] stores 2*n reads, where sample[i] and sample[i + n] form a pair.
+ * Return the total number of pairs that are not of low complexity.
  */
-void get_super_sketches (std::vector<sketch_t>& super_sketches,
-	const std::string& f, const std::string& f2, xny::sketch_list& slistgen,
-	xny::super_sketch& ssgen, jaz::murmur264& hashfunc, int batch, bool silent) {
+int sample_pairs (strvec_t& sample, const std::string& f,
+		const std::string& f2, xny::low_complexity& lc, int sample_sz,
+		int batch) {
 
 	std::ifstream fh, fh2;
 	xny::openfile<std::ifstream>(fh, f);
 	xny::openfile<std::ifstream>(fh2, f2);
 	bio::fastq_input_iterator<> fq(fh), end, fq2(fh2);
 
-	int total_read_pairs = 0;
-	strvec_t pairs;
-
+	std::mt19937_64 rng (2147483647);
+	strvec_t reservoir, pairs;
+	int total = 0;
 	while (fq != end && fq2 != end) {
-
  		add_fq_reads_only (pairs, batch/2, fq, end);
 		add_fq_reads_only (pairs, batch/2, fq2, end);
+		int num = pairs.size()/2;
+		cvec_t is_lc (num);
+		#pragma omp parallel for
+		for (int i = 0; i < num; ++ i) {
+			int counter[5] = {0, 0, 0, 0, 0};
+			lc.count (pairs[i].data(), pairs[i].length(), counter);
+			lc.count (pairs[i + num].data(), pairs[i + num].length(), counter);
+			is_lc[i] = lc (counter, pairs[i].length() + pairs[i + num].length());
+		}
 
-		generate_super_sketches (super_sketches, pairs, slistgen,
-				ssgen, hashfunc);
+		for (int i = 0; i < num; ++ i) {
+			if (is_lc[i]) continue;
+			if (total < sample_sz) {
+				reservoir.push_back(pairs[i]);
+				reservoir.push_back(pairs[i + num]);
+			} else {
+				int64_t j = rng() % (total + 1);
+				if (j < sample_sz) {
+					reservoir[2*j] = pairs[i];
+					reservoir[2*j + 1] = pairs[i + num];
+				}
+			}
+			++ total;
+		}
+		pairs.clear();
+	}
+	xny::closefile(fh);
+	xny::closefile(fh2);
 
-		total_read_pairs += pairs.size()/2;
+	// reorder to the layout used by generate_seeds ()
+	int n = reservoir.size()/2;
+	sample.resize(2 * n);
+	for (int i = 0; i < n; ++ i) {
+		sample[i] = reservoir[2*i];
+		sample[i + n] = reservoir[2*i + 1];
+	}
+	return total;
+} // sample_pairs
 
-		pairs.clear();
+/** Function estimate_library_size ()
+ *
+ * Solve the Lander-Waterman equation
+ * 		num_unique = X * (1 - exp (-num_pairs/X))
+ * for the library size X by bisection. Return -1 if X is unbounded, i.e.,
+ * no duplicates are observed.
+ */
+double estimate_library_size (double num_pairs, double num_unique) {
+	if (num_unique >= num_pairs || num_unique <= 0) return -1;
+
+	// f(x) = c/x - 1 + exp(-n/x) with x = ratio * c; f(1) > 0
+	double c = num_unique, n = num_pairs;
+	double lo = 1.0, hi = 100.0;
+	while (c/(hi*c) - 1 + std::exp(-n/(hi*c)) > 0) hi *= 10.0;
+	for (int i = 0; i < 40; ++ i) {
+		double mid = (lo + hi)/2.0;
+		double f = c/(mid*c) - 1 + std::exp(-n/(mid*c));
+		if (f == 0) break;
+		else if (f > 0) lo = mid;
+		else hi = mid;
+	}
+	return c * (lo + hi)/2.0;
+} // estimate_library_size
 
+/** Function stream_dupl_frag ()
+ *
+ * Single pass approximate duplicate removal of a pair of fq files. Each
+ * fragment is represented by two signatures: its exact fingerprint and its
+ * super sketch. A fragment is a duplicate if either signature is found in a
+ * fixed size cuckoo [filter]; otherwise both signatures are inserted and the
+ * fragment is written out immediately together with the earlier ones of the
+ * batch. Signatures are computed in parallel, the filter is queried and
+ * updated in input order so that the output is deterministic.
+ */
+template <typename fp_t>
+void stream_dupl_frag (const std::string& ifq, const std::string& ifq2,
+	std::ofstream& ofhfq, std::ofstream& ofhfq2, xny::cuckoo_filter<fp_t>& filter,
+	int w, int w2, xny::low_complexity& lc, int batch, bool silent) {
+
+	std::ifstream ifhfq, ifhfq2;
+	xny::openfile<std::ifstream>(ifhfq, ifq);
+	xny::openfile<std::ifstream>(ifhfq2, ifq2);
+	bio::fastq_input_iterator<> fq(ifhfq), end, fq2(ifhfq2);
+
+	jaz::murmur264 hashfunc (2147483647);
+
+	int total_read_pairs = 0, num_dupl = 0, num_lc = 0, num_full = 0;
+	std::vector<fqtuple_t> pairs;
+
+	while (fq != end && fq2 != end) {
+
+		add_fq_reads (pairs, batch/2, fq, end);
+		add_fq_reads (pairs, batch/2, fq2, end);
+
+		int fragnum = pairs.size()/2;
+		std::vector<uint64_t> fps (fragnum, 0), sss (fragnum, 0);
+		// char rather than bool: elements are written by different threads
+		std::vector<char> has_ss (fragnum, false), is_lc (fragnum, false);
+
+		#pragma omp parallel
+		{
+			xny::fragment_kernel kernel (1, w, w2);
+			std::string frag;
+			#pragma omp for
+			for (int i = 0; i < fragnum; ++ i) {
+				const std::string& r1 = std::get<1> (pairs[i]),
+						& r2 = std::get<1> (pairs[i + fragnum]);
+				kernel (r1, r2);
+				is_lc[i] = lc (kernel.composition(), kernel.length());
+				if (is_lc[i]) continue;
+				frag.assign (r1);
+				frag.append (r2);
+				fps[i] = hashfunc (frag);
+				has_ss[i] = kernel.super_sketch (sss[i], hashfunc);
+			}
+		}
+
+		for (int i = 0; i < fragnum; ++ i) {
+			if (is_lc[i]) {
+				++ num_lc;
+				continue;
+			}
+			if (filter.contains(fps[i]) ||
+				(has_ss[i] && filter.contains(sss[i]))) {
+				++ num_dupl;
+				continue;
+			}
+			if (! filter.insert(fps[i])) ++ num_full;
+			if (has_ss[i] && ! filter.insert(sss[i])) ++ num_full;
+
+			ofhfq << "@" << std::get<0>(pairs[i]) << "\n";
+			ofhfq << std::get<1>(pairs[i]) << "\n";
+			ofhfq << "+\n";
+			ofhfq << std::get<2>(pairs[i]) << "\n";
+
+			ofhfq2 << "@" << std::get<0>(pairs[i + fragnum]) << "\n";
+			ofhfq2 << std::get<1>(pairs[i + fragnum]) << "\n";
+			ofhfq2 << "+\n";
+			ofhfq2 << std::get<2>(pairs[i + fragnum]) << "\n";
+		}
+
+		total_read_pairs += fragnum;
+		pairs.clear();
 	} // while
 
+	xny::closefile(ifhfq);
+	xny::closefile(ifhfq2);
+
 	if (!silent) {
-		std::cout << "\t\t\ttotal pairs, super_sketches: " << total_read_pairs
-				<< ", " 	<< super_sketches.size() <<  "\n";
+		std::cout << "\t\ttotal frags: " << total_read_pairs << "\n";
+		std::cout << "\n\t\tnum duplicate frags: " << num_dupl << "("
+			<< (total_read_pairs ? 100 * num_dupl / total_read_pairs : 0)
+			<< "% total)\n";
+		std::cout << "\t\tlow complexity fragments: " << num_lc << "\n";
+		std::cout << "\t\tsignature filter: " << filter.bytes()/(1 << 20)
+			<< " MB, load " << filter.load_factor() << ", est. false positive"
+			<< " rate " << filter.fp_rate() << "\n\n";
 	}
+	if (num_full) {
+		warning ("signature filter is full, " + std::to_string(num_full) +
+			" signatures not recorded; increase -mem");
+	}
+} // stream_dupl_frag
+
+void stream_dupl_frag (const std::string& ifq, const std::string& ifq2,
+	std::ofstream& ofhfq, std::ofstream& ofhfq2, const drm_t& drm,
+	int w, int w2, xny::low_complexity& lc, int batch, int mem, bool silent) {
+
+	uint64_t bytes = (uint64_t) mem << 20;
+	if (drm.fp_bits == 8) {
+		xny::cuckoo_filter<uint8_t> filter (bytes);
+		stream_dupl_frag (ifq, ifq2, ofhfq, ofhfq2, filter, w, w2, lc,
+				batch, silent);
+	} else if (drm.fp_bits == 32) {
+		xny::cuckoo_filter<uint32_t> filter (bytes);
+		stream_dupl_frag (ifq, ifq2, ofhfq, ofhfq2, filter, w, w2, lc,
+				batch, silent);
+	} else {
+		xny::cuckoo_filter<uint16_t> filter (bytes);
+		stream_dupl_frag (ifq, ifq2, ofhfq, ofhfq2, filter, w, w2, lc,
+				batch, silent);
+	}
+} // stream_dupl_frag
+
+/** Function debug_print_fragments ()
+ * Given fragment IDs then print concatenated fragments from input fastq files
+ */
+void debug_print_fragments (const ivec_t& fragIDs, const std::string& fq,
+		const std::string& fq2) {
+
+	std::cout << "\nnum fragments: " << fragIDs.size() << "\n";
+	iset_t ids (fragIDs.begin(), fragIDs.end());
+	std::ifstream ifhfq, ifhfq2;
+	xny::openfile<std::ifstream>(ifhfq, fq);
+	xny::openfile<std::ifstream>(ifhfq2, fq2);
+	bio::fastq_input_iterator<> iter_fq (ifhfq), end, iter_fq2(ifhfq2);
+	int fragID = 0;
+	for (; iter_fq != end, iter_fq2 != end; ++ iter_fq, ++ iter_fq2) {
+		if (ids.count(fragID)) {
+			std::string frag = std::get<1>(*iter_fq) + std::get<1> (*iter_fq2);
+			std::cout << frag << "\n";
+		}
+		++ fragID;
+	}
+	xny::closefile(ifhfq);
+	xny::closefile(ifhfq2);
+} //debug_print_fragments
 
+/** Function get_umi_partitions ()
+ *
+ * Obtain the UMI of every fragment either from read names of fq file [f]
+ * or from the index-read fq file [f_umi], then group fragments whose UMIs
+ * differ by at most drm.umi_mm mismatches into the same partition.
+ * Output: [frag_part] fragID -> partition ID
+ */
+void get_umi_partitions (ivec_t& frag_part, const std::string& f,
+	const std::string& f_umi, const drm_t& drm, int batch, bool silent) {
+
+	strvec_t umis; // UMI per fragment
+	std::ifstream fh;
+	if (drm.umi_in_name) {
+		xny::openfile<std::ifstream>(fh, f);
+		bio::fastq_input_iterator<> fq(fh), end;
+		std::vector<fqtuple_t> reads;
+		while (fq != end) {
+			add_fq_reads (reads, batch, fq, end);
+			for (auto& r: reads) umis.push_back(get_umi_from_name(std::get<0>(r)));
+			reads.clear();
+		}
+	} else {
+		xny::openfile<std::ifstream>(fh, f_umi);
+		bio::fastq_input_iterator<> fq(fh), end;
+		std::vector<fqtuple_t> reads;
+		while (fq != end) {
+			add_fq_reads (reads, batch, fq, end);
+			for (auto& r: reads) {
+				std::string& umi = std::get<1>(r);
+				if (! xny::is_nt (umi)) {
+					abording ("no ACGTN UMI in index read " + std::get<0>(r) +
+							" of " + f_umi);
+				}
+				std::transform(umi.begin(), umi.end(), umi.begin(), ::toupper);
+				umis.push_back (umi);
+			}
+			reads.clear();
+		}
+	}
 	xny::closefile(fh);
-	xny::closefile(fh2);
-} // get_super_sketches
 
-/**	Function generate_super_sketches
+	int num_part = partition_umis (frag_part, umis, drm.umi_mm);
+
+	if (!silent) {
+		std::cout << "\t\t" << umis.size() << " UMIs in " << num_part
+				<< " partitions\n";
+	}
+} // get_umi_partitions
+
+/** Function get_umi_from_name ()
  *
- * Input: a list of read-pair sequences
- * Output: super sketches for each fragment
+ * Given a read name, e.g., M00:1:FC:1:1101:1000:2000:ACGTACGT 1:N:0:1 or
+ * read_ACGTACGT/1, the UMI is the last ':' or '_' delimited field of the
+ * first white space delimited token, with the mate suffix /1 or /2 removed.
+ * Abort if that field is empty or not ACGTN, e.g., the y-coordinate of a
+ * standard Illumina name without UMI.
  */
-void generate_super_sketches (std::vector<sketch_t>& super_sketches,
-		const strvec_t& pairs, xny::sketch_list& slistgen,
-		xny::super_sketch ssgen, jaz::murmur264& hashfunc) {
-	bool debug = false;
+std::string get_umi_from_name (const std::string& name) {
+	std::string token = name.substr(0, name.find_first_of(" \t"));
+	int len = token.length();
+	if (len > 2 && token[len - 2] == '/') token.resize(len - 2);
+	std::string::size_type pos = token.find_last_of(":_");
+	std::string umi = pos == std::string::npos ? "" : token.substr(pos + 1);
+	if (! xny::is_nt (umi)) abording ("no ACGTN UMI in read name " + name);
+	std::transform(umi.begin(), umi.end(), umi.begin(), ::toupper);
+	return umi;
+} // get_umi_from_name
+
+/** Function partition_umis ()
+ *
+ * Union distinct UMIs that are within [max_mismatch] (<= 1) substitutions
+ * by enumerating all single-substitution neighbours of each UMI. Every
+ * fragment is then assigned the partition ID of its UMI.
+ * Return the number of partitions.
+ */
+int partition_umis (ivec_t& frag_part, const strvec_t& umis, int max_mismatch){
+
+	// distinct UMIs -> IDs
+	std::map<std::string, int> umi2id;
+	for (auto& u: umis) {
+		if (!umi2id.count(u)) {
+			int id = umi2id.size();
+			umi2id[u] = id;
+		}
+	}
+	int num_umi = umi2id.size();
+	ivec_t uf (num_umi);
+	for (int j = 0; j < num_umi; ++ j) uf[j] = j;
+
+	if (max_mismatch > 0) {
+		const std::string alphabet = "ACGTN";
+		for (auto& x: umi2id) {
+			std::string nb = x.first;
+			for (unsigned int p = 0; p < nb.length(); ++ p) {
+				char c = nb[p];
+				for (auto& a: alphabet) {
+					if (a == c) continue;
+					nb[p] = a;
+					std::map<std::string, int>::iterator it = umi2id.find(nb);
+					if (it != umi2id.end()) {
+						int root_i = uf_find (x.second, uf),
+							root_j = uf_find (it->second, uf);
+						uf[root_j] = root_i;
+					}
+				}
+				nb[p] = c;
+			}
+		}
+	}
 
-	int num_frag = pairs.size()/2;
-	int fragID = super_sketches.size();
+	// compact roots to consecutive partition IDs
+	ivec_t root2part (num_umi, -1);
+	int num_part = 0;
+	for (int j = 0; j < num_umi; ++ j) {
+		int root = uf_find (j, uf);
+		if (root2part[root] == -1) root2part[root] = num_part ++;
+	}
+	frag_part.resize(umis.size());
+	for (unsigned int j = 0; j < umis.size(); ++ j) {
+		frag_part[j] = root2part[uf_find (umi2id[umis[j]], uf)];
+	}
+	return num_part;
+} // partition_umis
 
-	std::vector<sketch_t> batch_sketches (num_frag);
+/**	Function clustering_via_ss
+ *
+ *	Input 1) fragments in binary representation [list_seeds]
+ *		  2) [super_sketches] for each fragment, sorted here
+ *		  3) [frag_part] UMI partition of each fragment, can be empty
+ *	Return the number of duplicate fragments
+ */
+int clustering_via_ss (ivec_t& uf_clst, const ii64vec_t& list_seeds,
+	const ivec_t& frag_part, std::vector<sketch_t>& super_sketches,
+	int max_mismatch, cls_stats_vec_t& stats, bool silent) {
 
-	#pragma omp parallel for
-	for (int i = 0; i < num_frag; ++ i) {
-		std::string frag = pairs[i] + pairs[i + num_frag];
-		if (frag.size()) {
-			if (std::isupper(frag.at(0))) {
-				std::replace (frag.begin(), frag.end(), 'N', 'A');
-			} else std::replace (frag.begin(), frag.end(), 'n', 'a');
+	int sz = list_seeds.size();
+	if (sz == 0) return 0;
+	stats.push_back (cls_stats_t ("ss_" + std::to_string(stats.size())));
+	double timing = get_time();
+
+	std::sort(super_sketches.begin(), super_sketches.end(),
+				cmp_part_sketch(frag_part));
+
+	if (sz != (int) super_sketches.size()) abording ("clusetring_via_ss SC failed.");
+
+	// In [init_clusters], each 1d elem stores the indices of
+	// [list_seeds] that share the same super sketch, where in [list_seeds],
+	// the index i should be equal to fragID
+	iivec_t init_clusters (1, ivec_t{super_sketches[0].second});
+	for (int i = 1; i < sz; ++ i) {
+		if (super_sketches[i].first == super_sketches[i-1].first &&
+			same_part (frag_part, super_sketches[i].second,
+					super_sketches[i-1].second)) {
+			init_clusters.rbegin()->push_back(super_sketches[i].second);
+		} else init_clusters.push_back({super_sketches[i].second});
+	}
 
-			std::vector<sketch_t> slist = slistgen (frag, hashfunc);
-			std::sort (slist.begin(), slist.end(), xny::cmp_sketch());
-			ssgen (batch_sketches[i], slist, hashfunc);
-			batch_sketches[i].second = fragID + i;
-		}
+	int init_sz = init_clusters.size();
+
+	if (!silent){
+		std::cout << "\t\t\t" << init_sz << " clusters to validate\n";
 	}
 
-	super_sketches.insert (super_sketches.end(),
-			batch_sketches.begin(), batch_sketches.end());
-} //generate_super_sketches
+	validate_clusters (uf_clst, init_clusters, list_seeds, max_mismatch,
+			INT_MAX, stats.back());
+	stats.back().seconds = get_time() - timing;
+	if (!silent){
+		std::cout << "\t\t\tmax cls found: " << stats.back().max_bucket << "\n";
+	}
+
+	// ---- generate final union find clusters ------
+	iivec_t clusters;
+	uf_generate_cls (clusters, uf_clst);
+
+	// ---- count the duplicated fragments ----------------
+	int num_dupl = 0;
+	for (int i = 0; i < (int) clusters.size(); ++ i) {
+		num_dupl += clusters[i].size() - 1;
+	}
+	return num_dupl;
+} // clustering_via_ss
+
 
 /**	Function clustering ()
  *
@@ -336,9 +949,18 @@ void generate_super_sketches (std::vector<sketch_t>& super_sketches,
  *	and [uf_clust] is only checked but not updated for fragment comparison.
  *	Once local clusters were generated, [uf_clust] is then updated to reflect
  *	the clustering. The purpose of using this approach is to use OMP
+ *
+ *	If [frag_part] is not empty, only fragments of the same partition
+ *	share a chunk.
+ *
+ *	If [max_seed_frq] > 0, chunks of more than [max_seed_frq] fragments
+ *	sharing a seed (adapter dimers, homopolymers, very deep amplicons) are masked
+ *	instead of being compared pairwise, and their fragments are handled by
+ *	clustering_masked_frags ().
  */
 void clustering_via_seeds (ivec_t& uf_clst, ii64vec_t& list_seeds,
-		int num_seed, int max_mismatch, bool silent) {
+		const ivec_t& frag_part, int num_seed, int max_mismatch,
+		int max_seed_frq, cls_stats_vec_t& stats, bool silent) {
 	bool debug = false;
 
 	if (list_seeds.size() == 0 || list_seeds[0].size() == 0) {
@@ -347,6 +969,8 @@ void clustering_via_seeds (ivec_t& uf_clst, ii64vec_t& list_seeds,
 
 	int sz = list_seeds.size();
 
+	ivec_t num_masked (sz, 0); // fragID -> number of rounds masked
+
 	// -------- cluster according to seed i ---------
 	int num_seed_to_check = std::min(num_seed, max_mismatch + 1);
 	num_seed_to_check = std::min (5, num_seed_to_check); // cap at 5 iterations
@@ -355,15 +979,20 @@ void clustering_via_seeds (ivec_t& uf_clst, ii64vec_t& list_seeds,
 		if (!silent) {
 			std::cout << "\t\tcluster by seed " << seed_i << "\n";
 		}
+		stats.push_back (cls_stats_t ("seed_" + std::to_string(seed_i)));
+		double timing = get_time();
 
-		std::sort (list_seeds.begin(), list_seeds.end(), cmp_seed(seed_i));
+		std::sort (list_seeds.begin(), list_seeds.end(),
+				cmp_seed(seed_i, frag_part));
 
 		// linear scan the sorted [list_seeds] wrt the ith seed, and
 		// generate 2d vector, where each dimension stores the indices of
 		// [list_seeds] that share the same seed
 		iivec_t init_clusters (1, ivec_t{0});
 		for (int i = 1; i < sz; ++ i) {
-			if (list_seeds[i][seed_i] == list_seeds[i - 1][seed_i]) {
+			if (list_seeds[i][seed_i] == list_seeds[i - 1][seed_i] &&
+				same_part (frag_part, list_seeds[i].back(),
+						list_seeds[i - 1].back())) {
 				init_clusters.rbegin()->push_back(i);
 
 				/*
@@ -379,43 +1008,175 @@ void clustering_via_seeds (ivec_t& uf_clst, ii64vec_t& list_seeds,
 			} else init_clusters.push_back({i});
 		}
 
+		// ------- mask chunks of over-represented seeds ----------
+		int num_masked_cls = 0;
+		if (max_seed_frq > 0) {
+			iivec_t kept_clusters;
+			for (auto& cls: init_clusters) {
+				if ((int) cls.size() > max_seed_frq) {
+					for (auto idx: cls) ++ num_masked[list_seeds[idx].back()];
+					++ num_masked_cls;
+				} else kept_clusters.push_back (std::move (cls));
+			}
+			init_clusters.swap (kept_clusters);
+		}
+
 		int init_sz = init_clusters.size();
 
 		if (!silent){
-			std::cout << "\t\t" << init_sz << " clusters to validate\n";
+			std::cout << "\t\t" << init_sz << " clusters to validate";
+			if (num_masked_cls) {
+				std::cout << ", " << num_masked_cls << " masked";
+			}
+			std::cout << "\n";
 		}
 		//------- generate clusters: parallel clustering for each chunk
 		// of boundary then merge to the global cluster -------------
 		validate_clusters (uf_clst, init_clusters, list_seeds, max_mismatch,
-				20000);
+				20000, stats.back());
+		stats.back().num_masked = num_masked_cls;
+		stats.back().seconds = get_time() - timing;
+		if (!silent){
+			std::cout << "\t\t\tmax cls found: " << stats.back().max_bucket << "\n";
+		}
 
 	} // for (int seed_i = 0; seed_i < num_seeds; ++ seed_i) {
 
+	if (max_seed_frq > 0) {
+		clustering_masked_frags (uf_clst, list_seeds, frag_part, num_masked,
+			num_seed_to_check, max_seed_frq, max_mismatch, stats,
+			silent);
+	}
+
 } // clustering_via_seeds
 
+/**	Function clustering_masked_frags ()
+ *
+ *	Fragments that fell into masked chunks of clustering_via_seeds () are
+ *	grouped by their exact fingerprint (all seeds identical), which collapses
+ *	the bulk of an over-represented sequence in O(n log n). Fragments whose
+ *	seeds were masked in all [num_rounds] rounds are further clustered by
+ *	their remaining seeds (positions >= [num_rounds]) that are not
+ *	over-represented themselves. The frequency of such a seed is counted
+ *	exactly among the lost fragments by sorting them on that seed.
+ */
+void clustering_masked_frags (ivec_t& uf_clst, const ii64vec_t& list_seeds,
+		const ivec_t& frag_part, const ivec_t& num_masked, int num_rounds,
+		int max_seed_frq, int max_mismatch, cls_stats_vec_t& stats,
+		bool silent) {
+
+	int sz = list_seeds.size();
+	ivec_t masked, lost; // indices of [list_seeds]
+	int num_pos = 0;
+	for (int i = 0; i < sz; ++ i) {
+		int fragID = list_seeds[i].back();
+		if (num_masked[fragID] == 0) continue;
+		masked.push_back (i);
+		if (num_masked[fragID] == num_rounds) {
+			lost.push_back (i);
+			num_pos = std::max (num_pos, (int) list_seeds[i].size() - 1);
+		}
+	}
+	if (masked.empty()) return;
+
+	if (!silent) {
+		std::cout << "\t\tmasked fragments: " << masked.size() << " ("
+				<< lost.size() << " in all rounds)\n";
+	}
+
+	// -------- remaining seeds of fragments masked in all rounds ---------
+	for (int seed_i = num_rounds; seed_i < num_pos && lost.size() > 1;
+			++ seed_i) {
+		stats.push_back (cls_stats_t ("masked_seed_" + std::to_string(seed_i)));
+		double timing = get_time();
+		ivec_t idx;
+		for (auto i: lost) {
+			if ((int) list_seeds[i].size() - 1 > seed_i) idx.push_back (i);
+		}
+		std::sort (idx.begin(), idx.end(),
+				cmp_idx_seed (seed_i, list_seeds, frag_part));
+
+		iivec_t init_clusters;
+		for (int i = 0; i < (int) idx.size(); ++ i) {
+			if (i && list_seeds[idx[i]][seed_i] == list_seeds[idx[i-1]][seed_i]
+				&& same_part (frag_part, list_seeds[idx[i]].back(),
+						list_seeds[idx[i-1]].back())) {
+				init_clusters.rbegin()->push_back(idx[i]);
+			} else init_clusters.push_back({idx[i]});
+		}
+
+		iivec_t kept_clusters;
+		for (auto& cls: init_clusters) {
+			if ((int) cls.size() > max_seed_frq) {
+				++ stats.back().num_masked;
+			} else if (cls.size() > 1) {
+				kept_clusters.push_back (std::move (cls));
+			}
+		}
+		validate_clusters (uf_clst, kept_clusters, list_seeds, max_mismatch,
+				20000, stats.back());
+		stats.back().seconds = get_time() - timing;
+	}
+
+	// -------- exact fingerprints: identical seeds need no comparison -----
+	stats.push_back (cls_stats_t ("fingerprint"));
+	double timing = get_time();
+	std::sort (masked.begin(), masked.end(),
+			cmp_idx_seed (-1, list_seeds, frag_part));
+	for (int i = 1; i < (int) masked.size(); ++ i) {
+		const i64vec_t& s0 = list_seeds[masked[i - 1]],
+				& s1 = list_seeds[masked[i]];
+		if (s0.size() == s1.size() &&
+			std::equal (s0.begin(), s0.end() - 1, s1.begin()) &&
+			same_part (frag_part, s0.back(), s1.back())) {
+			int root_i = uf_find ((int) s0.back(), uf_clst),
+				root_j = uf_find ((int) s1.back(), uf_clst);
+			if (root_i != root_j) {
+				uf_clst[root_j] = root_i;
+				++ stats.back().num_unions;
+			}
+		}
+	}
+	stats.back().seconds = get_time() - timing;
+} // clustering_masked_frags
+
 /**	Function validate_clusters ()
  *
+ *	Bucket sizes, comparisons and unions are accumulated in [stat]
  */
 void validate_clusters (ivec_t& uf_clst, const iivec_t& init_clusters,
-	 const ii64vec_t& list_seeds, int max_mismatch, int max_cls_sz) {
+	 const ii64vec_t& list_seeds, int max_mismatch, int max_cls_sz,
+	 cls_stats_t& stat) {
 
 
 	iivec_t global_clusters;
 	int init_sz = init_clusters.size();
+	if (init_sz == 0) return;
+
+	// ---- bucket size histogram ----
+	for (int c = 0; c < init_sz; ++ c) {
+		int64_t bsz = init_clusters[c].size();
+		int b = 0;
+		while (bsz >> (b + 1)) ++ b;
+		if ((int) stat.bucket_hist.size() <= b) stat.bucket_hist.resize(b + 1, 0);
+		++ stat.bucket_hist[b];
+		stat.max_bucket = std::max (stat.max_bucket, bsz);
+		if (bsz > max_cls_sz) ++ stat.num_capped;
+	}
+	stat.num_buckets += init_sz;
 
-	ivec_t cls_sz (init_sz, 0);
+	int64_t num_cmp = 0, num_similar = 0;
 
-	#pragma omp parallel
+	#pragma omp parallel reduction(+:num_cmp,num_similar)
 	{
 		iivec_t private_clusters;
 		#pragma omp for // private (private_clusters) -- do not put private here otherwise it is private to the block only
 		for (int c = 0; c < init_sz; ++ c) {
 			if (init_clusters[c].size() > max_cls_sz) continue;
 
-			cls_sz[c] = init_clusters[c].size();
-
 			make_cluster (private_clusters, list_seeds,
-					init_clusters[c], max_mismatch, uf_clst);
+					init_clusters[c], max_mismatch, uf_clst, num_cmp,
+					num_similar);
 		}
 		#pragma omp critical
 		{
@@ -424,30 +1185,33 @@ void validate_clusters (ivec_t& uf_clst, const iivec_t& init_clusters,
 		}
 	} // #pragma omp parallel
 
-	for (int i = 1; i < init_sz; ++ i) cls_sz[0] = std::max(cls_sz[0], cls_sz[i]);
-	std::cout << "\t\t\tmax cls found: " << cls_sz[0] << "\n";
+	stat.num_cmp += num_cmp;
+	stat.num_similar += num_similar;
 
 	// now update [uf_clst] according to [global_clusters]
 	for (int i = 0; i < (int) global_clusters.size(); ++ i) {
-		update_uf (uf_clst, global_clusters[i]);
+		stat.num_unions += update_uf (uf_clst, global_clusters[i]);
 	}
 } // validate_clusters
 
 /**	Function update_uf()
  * 	Given fragment IDs of the same cluster, update the union find
- * 	structure [uf_clust] to reflect this information
+ * 	structure [uf_clust] to reflect this information. Return the number
+ * 	of unions of distinct roots
  */
-void update_uf (ivec_t& uf_clst, const ivec_t& clusters) {
-	int sz = clusters.size ();
+int update_uf (ivec_t& uf_clst, const ivec_t& clusters) {
+	int sz = clusters.size (), num_unions = 0;
 	for (int i = 0; i < sz - 1; ++ i) {
 		for (int j = i + 1; j < sz; ++ j) {
 			int fragID_i = clusters[i],
 				fragID_j = clusters[j];
 			int root_i = uf_find (fragID_i, uf_clst),
 				root_j = uf_find (fragID_j, uf_clst);
+			if (root_i != root_j) ++ num_unions;
 			uf_clst[root_j] = root_i;
 		}
 	}
+	return num_unions;
 } // update_uf
 
 /** Function make_cluster()
@@ -459,7 +1223,8 @@ void update_uf (ivec_t& uf_clst, const ivec_t& clusters) {
  *  stores the clustered fragment IDs.
  */
 void make_cluster (iivec_t& clusters, const ii64vec_t& list_seeds,
-		const ivec_t& init_cluster, int max_mismatch, const ivec_t& uf_clst) {
+		const ivec_t& init_cluster, int max_mismatch, const ivec_t& uf_clst,
+		int64_t& num_cmp, int64_t& num_similar) {
 
 	if (list_seeds.size() == 0) {
 		abording ("DuplRm.cpp -- make_cluster(): SC failed");
@@ -491,8 +1256,10 @@ void make_cluster (iivec_t& clusters, const ii64vec_t& list_seeds,
 					root_j = uf_find (j, clst);
 
 				if (root_i != root_j) {
+					++ num_cmp;
 					if (is_similar (list_seeds[idx_i], list_seeds[idx_j],
 							max_mismatch)) {
+						++ num_similar;
 						clst[root_j] = root_i;
 						visited[j] = true;
 					}
@@ -540,13 +1307,16 @@ bool is_similar (const i64vec_t& s0, const i64vec_t& s1, int max_mismatch){
 	return true;
 } // is_similar
 
-/** Function get_seeds()
+/** Function get_encoded_fragments ()
  *
- * Produce seeds: rID-> (s0, s1, s2...) for each fragment given two
- * fq files f and f2
+ * Produce seeds: rID-> (s0, s1, s2...), super sketches and low complexity
+ * flags for each fragment given two fq files f and f2
  */
-void get_seeds (ii64vec_t& list_seeds, const std::string& f,
-		const std::string& f2, int seed_len, int batch, bool silent) {
+void get_encoded_fragments (ii64vec_t& list_seeds,
+	std::vector<sketch_t>& super_sketches, bvec_t& is_lc,
+	const std::string& f, const std::string& f2, int seed_len, int w, int w2,
+	const jaz::murmur264& hashfunc, const xny::low_complexity& lc,
+	int batch, bool silent) {
 
 	std::ifstream fh, fh2;
 	xny::openfile<std::ifstream>(fh, f);
@@ -561,7 +1331,8 @@ void get_seeds (ii64vec_t& list_seeds, const std::string& f,
  		add_fq_reads_only (pairs, batch/2, fq, end);
 		add_fq_reads_only (pairs, batch/2, fq2, end);
 
-		generate_seeds (list_seeds, pairs, seed_len);
+		encode_fragments (list_seeds, super_sketches, is_lc, pairs, seed_len,
+				w, w2, hashfunc, lc);
 
 		total_read_pairs += pairs.size()/2;
 
@@ -575,121 +1346,85 @@ void get_seeds (ii64vec_t& list_seeds, const std::string& f,
 
 	xny::closefile(fh);
 	xny::closefile(fh2);
-} // get_seeds
+} // get_encoded_fragments
 
-/** Function generate_seeds ()
+/** Function encode_fragments ()
  *
  * Given [pairs] which stores 2*n number of reads, where pairs[i] and
- * pairs[i + n] for 0 <= i <= n - 1 form a read pair
+ * pairs[i + n] for 0 <= i <= n - 1 form a read pair, scan every fragment
+ * once with xny::fragment_kernel
  *
- * Output: [list_seeds] the non-overlapping seeds for each read pair
+ * Output: appended to [list_seeds] the non-overlapping seeds for each read
+ * pair, to [super_sketches] the super sketch (0 if the fragment is too
+ * short) and to [is_lc] whether the fragment is of low complexity
  */
-void generate_seeds (ii64vec_t& list_seeds, const strvec_t& pairs,
-		int seed_len) {
-	bool debug = false;
+void encode_fragments (ii64vec_t& list_seeds,
+	std::vector<sketch_t>& super_sketches, bvec_t& is_lc,
+	const strvec_t& pairs, int seed_len, int w, int w2,
+	const jaz::murmur264& hashfunc, const xny::low_complexity& lc) {
 
 	int num_pairs = pairs.size()/2;
 	int fragID = list_seeds.size();
 
-	ii64vec_t batch_seeds (num_pairs);
-
-	int debug_cnt = 0;
+	list_seeds.resize (fragID + num_pairs);
+	super_sketches.resize (fragID + num_pairs);
+	std::vector<char> batch_lc (num_pairs); // no shared bits across threads
 
-	#pragma omp parallel for
-	for (int i = 0; i < num_pairs; ++ i) {
-		std::string frag = pairs[i] + pairs[i + num_pairs];
-		if (frag.size()) {
-			if (std::isupper(frag.at(0))) {
-				std::replace (frag.begin(), frag.end(), 'N', 'A');
-			} else std::replace (frag.begin(), frag.end(), 'n', 'a');
-		}
-		get_seeds_per_fragment (batch_seeds[i], frag, seed_len);
-
-
-		if (debug) { // print out frag and its seeds
-
-			std::cout << frag << "\n";
-			int tmp_last_seed_len = frag.length() - seed_len * (frag.length()/seed_len);
-			std::cout << "fraglen, seed_len, last_seed_len = " << frag.length() << ", "
-					<< seed_len << ", " << tmp_last_seed_len << "\n";
-			for (auto& x : batch_seeds[i]) {
-				std::string d_fwd = xny::ID2Str<int64_t>(x, seed_len);
-				std::cout << d_fwd << "\t" << xny::get_rvc_str(d_fwd) << "\n";
-			}
-			if (tmp_last_seed_len != 0) {
-				std::cout << "last str: ";
-				std::string d_fwd = xny::ID2Str<int64_t>(batch_seeds[i].back(),
-						tmp_last_seed_len);
-				std::cout << d_fwd << "\t" << xny::get_rvc_str(d_fwd) <<  "\n";
-			}
-			debug_cnt ++;
-			if (debug_cnt > 2) exit(1);
-		}
-
-		// append to the seed list the fragment ID
-		batch_seeds[i].push_back(fragID + i);
-
-		if (debug) { // debug print
-			std::cout << frag << "\n";
-			for (int j = 0; j < batch_seeds[i].size(); ++ j) {
-				std::cout << batch_seeds[i][j] << "  ";
-			}
-			std::cout << "\n\n";
-			++ debug_cnt;
-			if (debug_cnt > 50) exit(1);
+	#pragma omp parallel
+	{
+		xny::fragment_kernel kernel (seed_len, w, w2);
+		#pragma omp for
+		for (int i = 0; i < num_pairs; ++ i) {
+			kernel (pairs[i], pairs[i + num_pairs]);
+			batch_lc[i] = lc (kernel.composition(), kernel.length());
+
+			i64vec_t& seeds = list_seeds[fragID + i];
+			kernel.seeds (seeds);
+			seeds.push_back (fragID + i);
+
+			sketch_t& ss = super_sketches[fragID + i];
+			ss.first = 0;
+			kernel.super_sketch (ss.first, hashfunc);
+			ss.second = fragID + i;
 		}
 	}
+	is_lc.insert (is_lc.end(), batch_lc.begin(), batch_lc.end());
+} // encode_fragments
 
-	list_seeds.insert (list_seeds.end(),
-			batch_seeds.begin(), batch_seeds.end());
-} // generate_seeds
-
-/**	Function get_seeds_per_fragment ()
+/** Function generate_seeds ()
  *
- * For each fragment, generate non-overlapping seeds according to
- * num_seed and seed_len. Consider both forward and reverse complementary
- * for each seed and select whichever is larger
+ * Given [pairs] which stores 2*n number of reads, where pairs[i] and
+ * pairs[i + n] for 0 <= i <= n - 1 form a read pair
  *
- * Note: the last seed may be shorter than seed_len
+ * Output: [list_seeds] the non-overlapping seeds for each read pair
  */
-void get_seeds_per_fragment (i64vec_t& seeds, const std::string& frag,
+void generate_seeds (ii64vec_t& list_seeds, const strvec_t& pairs,
 		int seed_len) {
 
-	int fraglen = frag.length();
-	int num_seed = fraglen/seed_len;
+	int num_pairs = pairs.size()/2;
+	int fragID = list_seeds.size();
 
-	/* first go through seeds with length [seed_len] */
-	seeds.resize(num_seed, -1);
+	list_seeds.resize (fragID + num_pairs);
 
-	for (int i = 0; i < num_seed; ++ i) {
-		if (i*seed_len + seed_len > frag.length()) {
-			abording ("get_seeds_per_fragment -- SC: seed out of range");
-		}
-		int64_t id;
-		if (xny::str2ID<int64_t> (id, frag.substr(i*seed_len, seed_len))) {
-			seeds [i] = std::max(id, xny::get_rvc_bits (id, seed_len));
+	#pragma omp parallel
+	{
+		xny::fragment_kernel kernel (seed_len, 1, 1);
+		#pragma omp for
+		for (int i = 0; i < num_pairs; ++ i) {
+			kernel (pairs[i], pairs[i + num_pairs]);
+			i64vec_t& seeds = list_seeds[fragID + i];
+			kernel.seeds (seeds);
+			seeds.push_back (fragID + i);
 		}
 	}
-
-	/* possible last remaining seed with len < seed_len */
-	int last_seed_len = fraglen - num_seed * seed_len;
-	if (last_seed_len != 0) {
-		int64_t id;
-		if (xny::str2ID<int64_t> (id,
-				frag.substr(fraglen - last_seed_len, last_seed_len))) {
-			seeds.push_back(std::max(id,
-					xny::get_rvc_bits (id, last_seed_len)));
-		} else seeds.push_back(-1);
-	} // if (last_seed_len != 0)
-
-} // get_seeds_per_fragment
+} // generate_seeds
 
 /**	Function clean_dupl_frag ()
  *
  */
 void clean_dupl_frag (const std::string& ifq, const std::string& ifq2,
 	std::ofstream& ofhfq, std::ofstream& ofhfq2, const iset_t& duplIDs,
-	xny::low_complexity& lc, int batch){
+	const bvec_t& is_lc, int batch){
 
 	std::ifstream ifhfq, ifhfq2;
 	xny::openfile<std::ifstream>(ifhfq, ifq);
@@ -705,13 +1440,10 @@ void clean_dupl_frag (const std::string& ifq, const std::string& ifq2,
 
  		add_fq_reads (pairs, batch/2, fq, end);
 		add_fq_reads (pairs, batch/2, fq2, end);
-		iset_t low_complex_frag;
-		check_low_complexity (low_complex_frag, fragID, pairs, lc);
-		num_lc += low_complex_frag.size();
 		int fragnum = pairs.size()/2;
 		for (int i = 0; i < fragnum; ++ i) {
-			if ( (!duplIDs.count(fragID)) &&
-				 (!low_complex_frag.count(fragID))) { // output
+			if (is_lc[fragID]) ++ num_lc;
+			if ( (!duplIDs.count(fragID)) && (!is_lc[fragID])) { // output
 				ofhfq << "@" << std::get<0>(pairs[i]) << "\n";
 				ofhfq << std::get<1>(pairs[i]) << "\n";
 				ofhfq << "+\n";
@@ -737,18 +1469,3 @@ void clean_dupl_frag (const std::string& ifq, const std::string& ifq2,
 
 } // clean_dupl_frag
 
-
-void check_low_complexity (iset_t& low_complex_frag, int start_fragID,
-		const std::vector<fqtuple_t>& pairs, xny::low_complexity& lc){
-	int num_frag = pairs.size()/2;
-	bvec_t is_lc (num_frag);
-	#pragma omp parallel for
-	for (int i = 0; i < num_frag; ++ i) {
-		std::string frag = std::get<1> (pairs[i]) + std::get<1>(pairs[i + num_frag]);
-		is_lc[i] = lc (frag);
-	}
-
-	for (int i = 0; i < num_frag; ++ i) {
-		if (is_lc[i]) low_complex_frag.insert(i + start_fragID);
-	}
-} //check_low_complexity
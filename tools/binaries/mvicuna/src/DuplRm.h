@@ -19,71 +19,181 @@
 #ifndef DUPLRM_H_
 #define DUPLRM_H_
 
+#include <random>
 #include "xutil.h"
 #include "Parameter.h"
 #include "ReadBioFile.h"
+#include "BamIO.h"
 #include "xny/file_manip.hpp"
+#include "xny/seq_manip.hpp"
 #include "xny/seq_cmp.hpp"
 #include "xny/sketch.hpp"
+#include "xny/fragment_kernel.hpp"
+#include "xny/cuckoo_filter.hpp"
 #include "jaz/fastx_iterator.hpp"
 #include "jaz/hash.hpp"
 
+/* diagnostics of one clustering round of DupRm, see -drm_stats */
+struct cls_stats_t {
+	std::string round; // e.g. ss_0, seed_0, masked_seed_5, fingerprint
+	i64vec_t bucket_hist; // [b]: number of buckets of size [2^b, 2^(b+1))
+	int64_t num_buckets; // buckets passed to validation
+	int64_t num_capped; // buckets skipped by the size cap
+	int64_t num_masked; // buckets of over-represented seeds
+	int64_t max_bucket;
+	int64_t num_cmp; // is_similar () calls
+	int64_t num_similar; // is_similar () calls returning true
+	int64_t num_unions;
+	double seconds;
+	cls_stats_t (const std::string& name): round(name), num_buckets(0),
+		num_capped(0), num_masked(0), max_bucket(0), num_cmp(0),
+		num_similar(0), num_unions(0), seconds(0) {}
+};
+typedef std::vector<cls_stats_t> cls_stats_vec_t;
+
+std::string json_str (const std::string& s);
+void write_cls_stats (std::ofstream& oh, const std::string& f,
+	const std::string& f2, int num_frags, int num_dupl,
+	const cls_stats_vec_t& stats, bool first);
+
 void debug_print_fragments (const ivec_t& fragIDs, const std::string& fq,
 		const std::string& fq2);
 
 void duplicate_removal (const strvec_t& ifqs, const drm_t& drm, int w,
-		int w2, xny::low_complexity& lc, int batch, bool silent);
+		int w2, xny::low_complexity& lc, int batch, int mem, bool silent);
+
+void duplicate_removal_bam (const drm_t& drm, int w, int w2,
+		xny::low_complexity& lc, int batch, bool silent);
+
+bool get_bam_fragment (int& r1, int& r2, const strvec_t& recs);
+
+void get_seed_len (int& frag_len, int& ub_mismatch, int& seed_len,
+		const std::string& fq, int perc_sim);
+
+void get_seed_len (int& frag_len, int& ub_mismatch, int& seed_len,
+		int read_len, int perc_sim);
+
+void estimate_dupl_rate (const strvec_t& ifqs, const drm_t& drm,
+		xny::low_complexity& lc, int sample_sz, int batch, bool silent);
+
+int sample_pairs (strvec_t& sample, const std::string& f,
+		const std::string& f2, xny::low_complexity& lc, int sample_sz,
+		int batch);
+
+double estimate_library_size (double num_pairs, double num_unique);
+
+void stream_dupl_frag (const std::string& ifq, const std::string& ifq2,
+	std::ofstream& ofhfq, std::ofstream& ofhfq2, const drm_t& drm,
+	int w, int w2, xny::low_complexity& lc, int batch, int mem, bool silent);
+
+void get_umi_partitions (ivec_t& frag_part, const std::string& f,
+	const std::string& f_umi, const drm_t& drm, int batch, bool silent);
 
-void clustering_via_ss (ivec_t& uf_clst, const ii64vec_t& list_seeds,
-	const std::string& f, const std::string& f2, int batch,
-	xny::sketch_list& slistgen, xny::super_sketch& ssgen, int max_mismatch,
-	bool silent);
+std::string get_umi_from_name (const std::string& name);
 
-void get_super_sketches (std::vector<sketch_t>& super_sketches,
-	const std::string& f, const std::string& f2, xny::sketch_list& slistgen,
-	xny::super_sketch& ssgen, jaz::murmur264& hashfunc, int batch, bool silent);
+int partition_umis (ivec_t& frag_part, const strvec_t& umis, int max_mismatch);
 
-void generate_super_sketches (std::vector<sketch_t>& super_sketches,
-		const strvec_t& pairs, xny::sketch_list& slistgen,
-		xny::super_sketch ssgen, jaz::murmur264& hashfunc);
+int clustering_via_ss (ivec_t& uf_clst, const ii64vec_t& list_seeds,
+	const ivec_t& frag_part, std::vector<sketch_t>& super_sketches,
+	int max_mismatch, cls_stats_vec_t& stats, bool silent);
 
-void get_seeds (ii64vec_t& list_seeds, const std::string& f,
-		const std::string& f2, int seed_len, int batch, bool silent);
+void get_encoded_fragments (ii64vec_t& list_seeds,
+	std::vector<sketch_t>& super_sketches, bvec_t& is_lc,
+	const std::string& f, const std::string& f2, int seed_len, int w, int w2,
+	const jaz::murmur264& hashfunc, const xny::low_complexity& lc,
+	int batch, bool silent);
+
+void encode_fragments (ii64vec_t& list_seeds,
+	std::vector<sketch_t>& super_sketches, bvec_t& is_lc,
+	const strvec_t& pairs, int seed_len, int w, int w2,
+	const jaz::murmur264& hashfunc, const xny::low_complexity& lc);
 
 void generate_seeds (ii64vec_t& list_seeds, const strvec_t& pairs,
 	int seed_len);
 
-void get_seeds_per_fragment (i64vec_t& seeds, const std::string& frag,
-	 int seed_len);
-
 void clustering_via_seeds (ivec_t& uf_clst, ii64vec_t& list_seeds,
-		int num_seed, int max_mismatch, bool silent);
+		const ivec_t& frag_part, int num_seed, int max_mismatch,
+		int max_seed_frq, cls_stats_vec_t& stats, bool silent);
+
+void clustering_masked_frags (ivec_t& uf_clst, const ii64vec_t& list_seeds,
+		const ivec_t& frag_part, const ivec_t& num_masked, int num_rounds,
+		int max_seed_frq, int max_mismatch, cls_stats_vec_t& stats, bool silent);
 
 void validate_clusters (ivec_t& uf_clst, const iivec_t& init_clusters,
-	 const ii64vec_t& list_seeds, int max_mismatch, int max_cls_sz);
+	 const ii64vec_t& list_seeds, int max_mismatch, int max_cls_sz,
+	 cls_stats_t& stat);
 
 void make_cluster (iivec_t& clusters, const ii64vec_t& list_seeds,
-		const ivec_t& init_cluster, int max_mismatch, const ivec_t& uf_clst);
+		const ivec_t& init_cluster, int max_mismatch, const ivec_t& uf_clst,
+		int64_t& num_cmp, int64_t& num_similar);
 
-void update_uf (ivec_t& uf_clst, const ivec_t& clusters) ;
+int update_uf (ivec_t& uf_clst, const ivec_t& clusters) ;
 
 bool is_similar (const i64vec_t& s0, const i64vec_t& s1, int max_mismatch);
 
 void clean_dupl_frag (const std::string& ifq, const std::string& ifq2,
 	std::ofstream& ofhfq, std::ofstream& ofhfq2, const iset_t& duplIDs,
-	xny::low_complexity& lc, int batch);
+	const bvec_t& is_lc, int batch);
 
-void check_low_complexity (iset_t& low_complex_frag, int start_fragID,
-		const std::vector<fqtuple_t>& pairs, xny::low_complexity& lc);
+/* check if two fragments fall in the same partition [frag_part];
+ * an empty [frag_part] puts all fragments in one partition */
+inline bool same_part (const ivec_t& frag_part, int fragID, int fragID2) {
+	return frag_part.empty() || frag_part[fragID] == frag_part[fragID2];
+}
 
-/* sort seeds wrt the idx-th element */
+/* sort seeds wrt the partition of the fragment then the idx-th element */
 struct cmp_seed{
 public:
-	cmp_seed (int index): idx_(index) {}
-	bool operator () (const i64vec_t& lhs, const i64vec_t& rhs)
-	const {	return lhs[idx_] < rhs[idx_]; }
+	cmp_seed (int index, const ivec_t& frag_part):
+		idx_(index), part_(frag_part) {}
+	bool operator () (const i64vec_t& lhs, const i64vec_t& rhs) const {
+		if (!part_.empty()) {
+			int pl = part_[lhs.back()], pr = part_[rhs.back()];
+			if (pl != pr) return pl < pr;
+		}
+		return lhs[idx_] < rhs[idx_];
+	}
+private:
+	int idx_;
+	const ivec_t& part_;
+};
+
+/* sort indices of [list_seeds] wrt the partition of the fragment then the
+ * idx-th seed; if idx < 0, then all seeds (exact fingerprint) */
+struct cmp_idx_seed{
+public:
+	cmp_idx_seed (int index, const ii64vec_t& list_seeds,
+		const ivec_t& frag_part): idx_(index), seeds_(list_seeds),
+		part_(frag_part) {}
+	bool operator () (int lhs, int rhs) const {
+		const i64vec_t& l = seeds_[lhs], & r = seeds_[rhs];
+		if (!part_.empty()) {
+			int pl = part_[l.back()], pr = part_[r.back()];
+			if (pl != pr) return pl < pr;
+		}
+		if (idx_ >= 0) return l[idx_] < r[idx_];
+		return std::lexicographical_compare (l.begin(), l.end() - 1,
+				r.begin(), r.end() - 1);
+	}
 private:
 	int idx_;
+	const ii64vec_t& seeds_;
+	const ivec_t& part_;
+};
+
+/* sort super sketches wrt the partition of the fragment then the value */
+struct cmp_part_sketch{
+public:
+	cmp_part_sketch (const ivec_t& frag_part): part_(frag_part) {}
+	bool operator () (const sketch_t& lhs, const sketch_t& rhs) const {
+		if (!part_.empty()) {
+			int pl = part_[lhs.second], pr = part_[rhs.second];
+			if (pl != pr) return pl < pr;
+		}
+		return lhs.first < rhs.first;
+	}
+private:
+	const ivec_t& part_;
 };
 
 
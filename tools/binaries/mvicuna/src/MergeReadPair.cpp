@@ -27,7 +27,7 @@ void debug_output_to_file (std::ofstream& ofh, std::vector<fqtuple_t>& seq){
 }
 
 void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
-		const std::string& os, int batch) {
+		const std::string& os, bool trim_adapter, int batch) {
 
 	// sanity check
 	if (os.empty()) abording ("merge_paired_read: ofa is empty");
@@ -37,8 +37,9 @@ void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
 	xny::openfile<std::ofstream> (ofhfq2, ofq.second);
 	xny::openfile<std::ofstream> (ofhs, os);
 
-	int num_merged_pairs = 0, total_read_pairs = 0;
+	int num_merged_pairs = 0, total_read_pairs = 0, num_trimmed = 0;
 	std::vector<fqtuple_t> seq;
+	merge_arena_t arenas;
 	int cnt = batch;
 	for (unsigned int i = 0; i < ifq.size(); i += 2) {
 
@@ -73,7 +74,8 @@ void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
 
 			if ((int) seq.size() >= batch) {
 				total_read_pairs += seq.size()/2;
-				num_merged_pairs += apply_merging (ofhs, ofhfq, ofhfq2, seq);
+				num_merged_pairs += apply_merging (ofhs, ofhfq, ofhfq2, seq,
+						arenas, trim_adapter, num_trimmed);
 				cnt = batch;
 				seq.clear();
 			} else { // not enough reads to fill in batch for current file pair
@@ -85,11 +87,16 @@ void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
 
 	}
 	total_read_pairs += seq.size()/2;
-	num_merged_pairs += apply_merging (ofhs, ofhfq, ofhfq2, seq);
+	num_merged_pairs += apply_merging (ofhs, ofhfq, ofhfq2, seq, arenas,
+			trim_adapter, num_trimmed);
 
 	std::cout << "\tnumber of merged pairs vs total: " << num_merged_pairs
 			<< " vs " << total_read_pairs << " ("
 			<< 100.0*num_merged_pairs /total_read_pairs << "%) \n";
+	if (trim_adapter) {
+		std::cout << "\tnumber of merged pairs with adapter read-through trimmed: "
+				<< num_trimmed << "\n";
+	}
 
 	xny::closefile (ofhfq);
 	xny::closefile (ofhfq2);
@@ -99,6 +106,39 @@ void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
 
 
 
+/* consensus of two aligned bases given their quality chars: entry
+ * [match][q0][q1] keeps the higher quality in the low 7 bits and sets the
+ * top bit if the base of the second read is taken (mismatch and q1 > q0)
+ */
+struct consensus_lut_t {
+	uint8_t entry[2][128][128];
+
+	consensus_lut_t () {
+		for (int m = 0; m < 2; ++ m) {
+			for (int q0 = 0; q0 < 128; ++ q0) {
+				for (int q1 = 0; q1 < 128; ++ q1) {
+					bool take1 = (m == 0 && q1 > q0);
+					entry[m][q0][q1] = std::max (q0, q1) | (take1 ? 128 : 0);
+				}
+			}
+		}
+	}
+};
+
+/* complement of a base, non-ACGTacgt chars become 'N' as in xny::rvc_str */
+struct complement_lut_t {
+	char base[256];
+
+	complement_lut_t () {
+		for (int c = 0; c < 256; ++ c) base[c] = 'N';
+		const char* from = "ACGTacgt", *to = "TGCAtgca";
+		for (int i = 0; i < 8; ++ i) base[(unsigned char) from[i]] = to[i];
+	}
+};
+
+static const consensus_lut_t consensus_lut;
+static const complement_lut_t complement_lut;
+
 /* @brief	Given n read-pairs (1, ...n, n+1, ..., 2n) stored in [seq],
  * where the reads (i, n+i) for 1 <= i <= n form a pair. Every pair is
  * attempted for merging, the ones failed merging are added to [fq] [fq2]
@@ -110,123 +150,153 @@ void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
  * 		OR abnormal case
  * 	<-----
  * 	    ----->
+ * The abnormal case is a pair whose insert is shorter than the reads,
+ * either read runs into the adapter beyond the overlap. If [trim_adapter],
+ * such merged reads are cut to the insert, the number of which is added
+ * to [num_trimmed], so no separate primer trimming is needed for them.
+ *
+ * The second read is used as reverse complement (sequence and quality)
+ * through its indices only, and is output unchanged if not merged. A
+ * merged read is written, sequence then quality, into the arena of the
+ * thread that merges it; [arenas] keep their capacity between batches.
  */
 int apply_merging (std::ofstream& fhs, std::ofstream& fhfq,
-		std::ofstream& fhfq2, std::vector<fqtuple_t>& seq) {
+		std::ofstream& fhfq2, std::vector<fqtuple_t>& seq,
+		merge_arena_t& arenas, bool trim_adapter, int& num_trimmed) {
 
-	bool debug = false;
-	int debug_cnter = 0;
-	// reverse complementary of second pair
 	int num = seq.size();
 
-	#pragma omp parallel for
-	for (int i = num/2; i < num; ++ i) {
-		xny::rvc_str(std::get<1> (seq[i]));
-	}
-
 	xny::suffix_prefix_gap_free_aln aligner (7, 90, 1);
-
-	std::vector<strpair_t> list_merged_fragments (num/2);
-
-	if (debug){ // debug case for merging
-		omp_set_num_threads(1);
-	}
-
-	#pragma omp parallel for
-	for (int i = num/2; i < num; ++ i) {
-
-		coord_t coord =	aligner (std::get<1> (seq[i-num/2]),
-				std::get<1> (seq[i]));
-
-		if (std::get<0> (coord) != -1) {
+	// fallback for overlaps with indels
+	xny::banded_overlap_aln gapped_aligner (20, 90, 3);
+
+	// (thread, offset in its arena, length) of each merged read
+	std::vector<std::tuple<int, size_t, int> > merged (num/2,
+			std::make_tuple (0, 0, 0));
+
+	arenas.resize (omp_get_max_threads());
+
+	int trimmed = 0; // reduction items cannot be references before OpenMP 4.5
+	#pragma omp parallel firstprivate (aligner, gapped_aligner)
+	{
+		int tid = omp_get_thread_num();
+		std::string& arena = arenas[tid];
+		arena.clear();
+
+		#pragma omp for reduction (+: trimmed)
+		for (int i = num/2; i < num; ++ i) {
+			const std::string& s0 = std::get<1> (seq[i-num/2]),
+					&q0 = std::get<2> (seq[i-num/2]),
+					&r1 = std::get<1> (seq[i]), &rq1 = std::get<2> (seq[i]);
+			int l0 = s0.length(), l1 = r1.length();
+
+			// coordinates on the second read refer to its reverse complement
+			coord_t coord =	aligner (s0.data(), l0, r1.data(), l1, true);
 			int start0 = std::get<0> (coord), end0 = std::get<1> (coord),
-				start1 = std::get<2> (coord), end1 = std::get<3> (coord),
-				l0 = (std::get<1> (seq[i-num/2])).length(),
-				l1 = (std::get<1> (seq[i])).length();
-
-			/*if (debug) { // debug print
-				std::cout << start0 << "\t" << end0 << "\t"
-						<< start1 << "\t" << end1 << "\n";
-				int num_dash = start0 - start1;
-				std::cout << std::get<1> (seq[i-num/2]) << "\n";
-				for (int g = 0; g < num_dash; ++ g) std::cout << "-";
-				std::cout << std::get<1> (seq[i]) << "\n\n";
-			}*/
-
-			// to merge
-			int overlap_sz = end0 - start0 + 1;
-			std::string merged_seq, merged_qual;
+				start1 = std::get<2> (coord), end1 = std::get<3> (coord);
+			// alignment columns, NULL for gap free
+			const std::string* ops = NULL;
+			if (start0 == -1) {
+				if (! gapped_aligner (s0.data(), l0, r1.data(), l1, true)) {
+					continue;
+				}
+				start0 = gapped_aligner.begin0();
+				end0 = gapped_aligner.end0();
+				start1 = gapped_aligner.begin1();
+				end1 = gapped_aligner.end1();
+				ops = &gapped_aligner.ops();
+			}
+			int overlap_sz = ops ? ops->size() : end0 - start0 + 1;
+
+			bool normal = (start0 + 1 >= l0 - end0 - 1);
+			if (! normal && trim_adapter) ++ trimmed;
+			// the insert always spans from the start of the first read to
+			// the end of the second; for an abnormal pair the parts beyond
+			// are adapter read-through
+			bool first_read_left = (normal || trim_adapter);
+			int pref_len = first_read_left ? start0 : start1,
+				suf_len = first_read_left ? l1 - end1 - 1 : l0 - end0 - 1,
+				len = pref_len + overlap_sz + suf_len; // upper bound if gapped
+
+			size_t off = arena.size();
+			arena.resize (off + 2 * len);
+			char* ms = &arena[off], *mq = ms + len;
+
+			// base and quality of position j of the reverse complement
+			auto rvc_base = [&] (int j) {
+				return complement_lut.base[(unsigned char) r1[l1 - j - 1]]; };
+			auto rvc_qual = [&] (int j) { return rq1[l1 - j - 1]; };
+
+			// prefix
+			for (int p = 0; p < pref_len; ++ p) {
+				if (first_read_left) { ms[p] = s0[p]; mq[p] = q0[p]; }
+				else { ms[p] = rvc_base(p); mq[p] = rvc_qual(p); }
+			}
+			// overlap: a base facing a gap is kept unless the other read
+			// has a higher quality at the preceding aligned column
+			char* os = ms + pref_len, *oq = mq + pref_len;
+			int j0 = start0, j1 = start1;
 			for (int idx = 0; idx < overlap_sz; ++ idx) {
-				char c0 = (std::get<1> (seq[i-num/2])).at(start0 + idx),
-					 c1 = (std::get<1> (seq[i])).at(start1 + idx),
-					 q0 = (std::get<2> (seq[i-num/2])).at(start0 + idx),
-					 q1 = (std::get<2> (seq[i])).at(start1 + idx);
-
-				if (c0 == c1) {
-					merged_seq += c0;
-					if (q0 >= q1) merged_qual += q0;
-					else merged_qual += q1;
-				} else {
-					if (q0 >= q1) {
-						merged_seq += c0;
-						merged_qual += q0;
-					} else {
-						merged_seq += c1;
-						merged_qual += q1;
+				char op = ops ? (*ops)[idx] : 'M';
+				if (op == 'M') {
+					char c0 = s0[j0], c1 = rvc_base(j1);
+					uint8_t e = consensus_lut.entry[c0 == c1]
+							[q0[j0] & 127][rvc_qual(j1) & 127];
+					*os ++ = (e & 128) ? c1 : c0;
+					*oq ++ = e & 127;
+					++ j0;
+					++ j1;
+				} else if (op == 'I') { // base of the first read only
+					if (q0[j0] >= rvc_qual(j1 - 1)) {
+						*os ++ = s0[j0];
+						*oq ++ = q0[j0];
 					}
+					++ j0;
+				} else { // base of the second read only
+					if (rvc_qual(j1) >= q0[j0 - 1]) {
+						*os ++ = rvc_base(j1);
+						*oq ++ = rvc_qual(j1);
+					}
+					++ j1;
 				}
-			} // for (int idx = 0;
-
-			//if (debug) std::cout << "Merged part: \n" << merged_seq << "\n";
-
-			// generate the full string
-			if (start0 + 1 >= l0 - end0 - 1) { // normal direction
-				merged_seq = (std::get<1> (seq[i-num/2])).substr(0, start0) + merged_seq;
-				merged_qual = (std::get<2> (seq[i-num/2])).substr(0, start0) + merged_qual;
-				if (end1 < l1 - 1) {
-					merged_seq += (std::get<1> (seq[i])).substr(end1 + 1, l1 - end1);
-					merged_qual += (std::get<2> (seq[i])).substr(end1 + 1, l1 - end1);
-				}
-			} else { // abnormal direction
-				merged_seq = (std::get<1> (seq[i])).substr(0, start1) + merged_seq;
-				merged_qual = (std::get<2> (seq[i])).substr(0, start1) + merged_qual;
-				if (end0 < l0 - 1) {
-					merged_seq += (std::get<1> (seq[i-num/2])).substr(end0 + 1, l0 - end0);
-					merged_qual += (std::get<2> (seq[i-num/2])).substr(end0 + 1, l0 - end0);
-				}
-
-				if (debug) {
-					std::cout << "> " << debug_cnter << "\n";
-					std::cout << merged_seq << "\n\n";
-
-					std::cout << std::get<0> (seq[i-num/2]) << "\n" << std::get<1> (seq[i-num/2]) << "\n";
-					std::cout << std::get<0> (seq[i]) << "\n" << std::get<1> (seq[i]) << "\n\n";
-
-					++ debug_cnter;
+			}
+			// suffix
+			for (int p = 0; p < suf_len; ++ p) {
+				if (first_read_left) {
+					os[p] = rvc_base(end1 + 1 + p);
+					oq[p] = rvc_qual(end1 + 1 + p);
+				} else {
+					os[p] = s0[end0 + 1 + p];
+					oq[p] = q0[end0 + 1 + p];
 				}
 			}
 
-			/*
-			if (debug){
-				std::cout << "post-merging, we have\n" << merged_seq
-						<< "\n" << merged_qual << "\n";
-			}*/
-
-			list_merged_fragments[i - num/2] = strpair_t (merged_seq,
-					merged_qual);
-
-
-		}  // if (std::get<0> (coord) != -1)
+			os += suf_len;
+			oq += suf_len;
+			if (os - ms < len) { // dropped gap columns: close up quality
+				int new_len = os - ms;
+				std::copy (mq, oq, ms + new_len);
+				len = new_len;
+				arena.resize (off + 2 * len);
+			}
 
-	} // 	for (int i = num/2; i < num; ++ i) {
+			merged[i - num/2] = std::make_tuple (tid, off, len);
+		} // for (int i = num/2; i < num; ++ i)
+	} // #pragma omp parallel
+	num_trimmed += trimmed;
 
 	/* write to file */
 	int merged_cnt = 0;
 	for (int i = 0; i < num/2; ++ i) {
-		if (!list_merged_fragments[i].first.empty()) {
-			fhs << "@" << std::get<0> (seq[i + num/2]) << "\n"
-					<< list_merged_fragments[i].first << "\n+\n"
-					<< list_merged_fragments[i].second << "\n";
+		int len = std::get<2> (merged[i]);
+		if (len > 0) {
+			const char* m = arenas[std::get<0> (merged[i])].data() +
+					std::get<1> (merged[i]);
+			fhs << "@" << std::get<0> (seq[i + num/2]) << "\n";
+			fhs.write (m, len);
+			fhs << "\n+\n";
+			fhs.write (m + len, len);
+			fhs << "\n";
 			++ merged_cnt;
 		} else {
 			fhfq << "@" << std::get<0> (seq[i]) << "\n"
@@ -239,9 +309,6 @@ int apply_merging (std::ofstream& fhs, std::ofstream& fhfq,
 	}
 
 	return merged_cnt;
-	//std::cout << "Number of merged read pairs = " << merged << "\n";
-	//
-	// suffix_prefix_gap_free_aln ();
 
 } // apply_merging
 
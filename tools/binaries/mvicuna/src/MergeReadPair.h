@@ -23,12 +23,17 @@
 #include "jaz/fastx_iterator.hpp"
 #include "xny/file_manip.hpp"
 #include "xny/seq_cmp.hpp"
+#include "xny/banded_aln.hpp"
+
+/* per-thread buffers of merged reads */
+typedef std::vector<std::string> merge_arena_t;
 
 void merge_paired_read (const strvec_t& ifq, const strpair_t& ofq,
-		const std::string& ofa, int batch);
+		const std::string& ofa, bool trim_adapter, int batch);
 
 
 int apply_merging (std::ofstream& fa, std::ofstream& fq, std::ofstream& fq2,
-	std::vector<fqtuple_t>& seq);
+	std::vector<fqtuple_t>& seq, merge_arena_t& arenas, bool trim_adapter,
+	int& num_trimmed);
 
 #endif /* MERGEREADPAIR_H_ */
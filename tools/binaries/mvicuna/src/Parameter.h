@@ -31,6 +31,15 @@ struct drm_t {
  	strvec_t op; // duplicate removed output paired fq files
 	int perc_sim;
 //	int max_mismatch;
+	bool umi_in_name; // UMI is the last ':' or '_' delimited field of read name
+	strvec_t umi_fq; // index-read fq files storing UMIs, one per input pair
+	int umi_mm; // max mismatches between UMIs of the same partition
+	bool stream; // single pass approximate duplicate removal
+	int fp_bits; // fingerprint bits of the signature filter in stream mode
+	int max_seed_frq; // seeds occurring more often are masked; 0: no masking
+	std::string stats; // JSON file of clustering diagnostics
+	std::string ibam; // query name grouped unaligned BAM input
+	std::string obam; // duplicate removed BAM output
 };
 
 /* task: Trim */
@@ -41,20 +50,44 @@ struct trm_t {
 	int min_match; // minimum match b/t read and vector to apply trim
 	int min_rlen; // minimum remaining read length
 	int min_qual;
+	std::string engine; // primer matching: kmer (seed & extend) or myers
+	int max_err; // max edit distance of a primer match, myers engine only
+	int win; // sliding window size of mean quality trimming, 0: disabled
+	int win_q; // min mean phred score of a sliding window
 };
 
 /* task: paired read merging */
 struct prm_t {
 	strpair_t op; // output unmerged pairs in fastq format
 	std::string os; // output merged seq in single-end fastq format
+	bool trim_adapter; // trim adapter read-through of overlapping pairs
+};
+
+/* task: sequence frequency estimate */
+struct fe_t {
+	int k; // k-mer size
+	std::string mode; // k-mer counting: exact (hash table), cms (sketch)
+					  // or disk (minimiser partitioned bins on disk)
+	int depth; // number of rows of the count-min sketch, cms mode only
+	int bins; // number of on-disk bins, disk mode only
+	std::string tmp; // directory of temporary files, disk mode only
+	std::string db_out; // k-mer count file to write
+	std::string db_in; // k-mer count file to load instead of counting
+	strvec_t op; // output paired fq files of kept pairs
+	std::string os; // output single end fq file of kept reads
+	std::string filtered; // prefix of output fq files of filtered reads
+	int max_frq; // reads of higher frequency are filtered, 0: no threshold
+	double quantile; // percentile of read frequencies used as threshold
+	std::string frq_out; // binary file of per-read frequencies
 };
 
 /* input parameters */
 class Parameter{
 
 public:
-    enum TaskList { DupRm, Trim, PairedReadMerge, SFrqEst };
-    strset_t task_set_ { "DupRm", "Trim", "PairedReadMerge", "SFrqEst"};
+    enum TaskList { DupRm, Trim, PairedReadMerge, SFrqEst, DupEst };
+    strset_t task_set_ { "DupRm", "Trim", "PairedReadMerge", "SFrqEst",
+    	"DupEst"};
 
 	strvec_t ipfq; // input paired-read comma separated fastq files;
 				  // pair1 and pair2 are adjacent to each other
@@ -75,16 +108,27 @@ public:
 	int batch; // number of of single read/contigs; paired reads to be
 			   // read into the memory
 	int pthreads;
+	int mem; // memory (MB) of fixed size structures in approximate modes
 	bool silent, noclean;
 
 	drm_t drm; // duplicate removal
 	trm_t trm; // trim
 	prm_t prm; // paired read merging
 
-	int fe_k; // sequence frequency estimate
+	fe_t fe; // sequence frequency estimate
+
+	int est_n; // number of pairs sampled to estimate the duplicate rate
 	/* task: high stringent clustering */
 	//bool	 t_hsc; // high stringent read clustering
 
+	/* true if some task writes fastq reads, i.e., -opfq and -osfq are
+	 * needed; not so for BAM input or DupEst only */
+	bool writes_fq () const {
+		if (drm.ibam.size()) return false;
+		for (auto& task: tasks) if (task != DupEst) return true;
+		return false;
+	}
+
 
 	Parameter (int argc, char** argv): argnum(argc), arg(argv){
 		init ();
@@ -137,6 +181,8 @@ public:
 						tasks[idx] = TaskList::PairedReadMerge;
 					} else if (x.compare ("SFrqEst") == 0){
 						tasks[idx] = TaskList::SFrqEst;
+					} else if (x.compare ("DupEst") == 0){
+						tasks[idx] = TaskList::DupEst;
 					} else {
 						std::cout << "task: " << x << "unrecognized\n";
 						exit(1);
@@ -180,6 +226,13 @@ public:
 			} else if (option.compare("-pthreads") == 0){
 				if (argc < i + 2) printUsage (argv[0]);
 				pthreads = atoi (argv[i+1]);
+			} else if (option.compare("-mem") == 0){
+				if (argc < i + 2) printUsage (argv[0]);
+				mem = atoi (argv[i+1]);
+				if (mem < 1) {
+					warning ("-mem is too small, it is reset to 1024");
+					mem = 1024;
+				}
 			} else if (option.compare("-silent") == 0) {
 				silent = true;
 				-- i;
@@ -200,6 +253,44 @@ public:
 		    			warning ("-drm_perc_sim is too small, it is reset to 95");
 		    			drm.perc_sim = 95;
 		    		}
+		    } else if (option.compare("-drm_umi") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				std::string tmp = argv[i + 1];
+				if (tmp.compare("name") == 0) drm.umi_in_name = true;
+				else split (',', tmp, std::back_inserter(drm.umi_fq));
+		    } else if (option.compare("-drm_stream") == 0) {
+		    		drm.stream = true;
+		    		-- i;
+		    } else if (option.compare("-drm_fp_bits") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.fp_bits = atoi (argv[i+1]);
+		    		if (drm.fp_bits != 8 && drm.fp_bits != 16 && drm.fp_bits != 32) {
+		    			warning ("-drm_fp_bits in {8, 16, 32}, reset to 16");
+		    			drm.fp_bits = 16;
+		    		}
+		    } else if (option.compare("-drm_ibam") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.ibam = argv[i+1];
+		    } else if (option.compare("-drm_obam") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.obam = argv[i+1];
+		    } else if (option.compare("-drm_stats") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.stats = argv[i+1];
+		    } else if (option.compare("-drm_max_seed_frq") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.max_seed_frq = atoi (argv[i+1]);
+		    		if (drm.max_seed_frq < 0) {
+		    			warning ("-drm_max_seed_frq is negative, it is reset to 0");
+		    			drm.max_seed_frq = 0;
+		    		}
+		    } else if (option.compare("-drm_umi_mm") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+		    		drm.umi_mm = atoi (argv[i+1]);
+		    		if (drm.umi_mm < 0 || drm.umi_mm > 1) {
+		    			warning ("-drm_umi_mm in [0, 1], reset to 1");
+		    			drm.umi_mm = 1;
+		    		}
 		    }/* else if (option.compare ("-drm_max_mismatch") == 0) {
 				if (argc < i + 2) printUsage (argv[0]);
 		    		drm.max_mismatch = atoi (argv[i + 1]);
@@ -217,6 +308,9 @@ public:
 			} else if (option.compare("-prm_os") == 0) {
 				if (argc < i + 2) printUsage (argv[0]);
 				prm.os = argv[i+1];
+			} else if (option.compare("-prm_trim_adapter") == 0) {
+				prm.trim_adapter = true;
+				-- i;
 			}
 
 			//-------------- Trim task ------------------
@@ -240,12 +334,108 @@ public:
 			} else if (option.compare ("-trm_q") == 0) {
 				if (argc < i + 2) printUsage (argv[0]);
 				trm.min_qual = atoi (argv[i + 1]);
+			} else if (option.compare ("-trm_engine") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				trm.engine = argv[i + 1];
+				if (trm.engine != "kmer" && trm.engine != "myers") {
+					abording ("-trm_engine: " + trm.engine + " unrecognized");
+				}
+			} else if (option.compare ("-trm_max_err") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				trm.max_err = atoi (argv[i + 1]);
+				if (trm.max_err < 0) {
+					warning ("-trm_max_err is negative, it is reset to 0");
+					trm.max_err = 0;
+				}
+			} else if (option.compare ("-trm_win") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				trm.win = atoi (argv[i + 1]);
+				if (trm.win < 0) {
+					warning ("-trm_win is negative, it is reset to 0");
+					trm.win = 0;
+				}
+			} else if (option.compare ("-trm_win_q") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				trm.win_q = atoi (argv[i + 1]);
 			}
 
 			//-------------- SFrqEst task ------------------
 			else if (option.compare("-fe_k") == 0) {
 				if (argc < i + 2) printUsage (argv[0]);
-				fe_k = atoi (argv[i+1]);
+				fe.k = atoi (argv[i+1]);
+				if (fe.k < 1 || fe.k > 32) {
+					warning ("-fe_k in [1, 32], reset to 14");
+					fe.k = 14;
+				}
+			} else if (option.compare("-fe_mode") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.mode = argv[i+1];
+				if (fe.mode != "exact" && fe.mode != "cms" && fe.mode != "disk") {
+					abording ("-fe_mode: " + fe.mode + " unrecognized");
+				}
+			} else if (option.compare("-fe_depth") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.depth = atoi (argv[i+1]);
+				if (fe.depth < 1 || fe.depth > 16) {
+					warning ("-fe_depth in [1, 16], reset to 4");
+					fe.depth = 4;
+				}
+			} else if (option.compare("-fe_bins") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.bins = atoi (argv[i+1]);
+				if (fe.bins < 1 || fe.bins > 512) {
+					warning ("-fe_bins in [1, 512], reset to 64");
+					fe.bins = 64;
+				}
+			} else if (option.compare("-fe_tmp") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.tmp = argv[i+1];
+			} else if (option.compare("-fe_db_out") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.db_out = argv[i+1];
+			} else if (option.compare("-fe_db_in") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.db_in = argv[i+1];
+			} else if (option.compare("-fe_op") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				std::string tmp = argv[i+1];
+				split(',', tmp, std::back_inserter(fe.op));
+				if (fe.op.size() != 2) {
+					abording ("-fe_op requires 2 output fq files\n type -h to get options");
+				}
+			} else if (option.compare("-fe_os") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.os = argv[i+1];
+			} else if (option.compare("-fe_filtered") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.filtered = argv[i+1];
+			} else if (option.compare("-fe_max_frq") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.max_frq = atoi (argv[i+1]);
+				if (fe.max_frq < 0) {
+					warning ("-fe_max_frq is negative, it is reset to 0");
+					fe.max_frq = 0;
+				}
+			} else if (option.compare("-fe_quantile") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.quantile = atof (argv[i+1]);
+				if (fe.quantile < 0 || fe.quantile > 100) {
+					warning ("-fe_quantile in [0, 100], reset to 0");
+					fe.quantile = 0;
+				}
+			} else if (option.compare("-fe_frq_out") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				fe.frq_out = argv[i+1];
+			}
+
+			//-------------- DupEst task ------------------
+			else if (option.compare("-est_n") == 0) {
+				if (argc < i + 2) printUsage (argv[0]);
+				est_n = atoi (argv[i+1]);
+				if (est_n < 1000) {
+					warning ("-est_n is too small, it is reset to 1000");
+					est_n = 1000;
+				}
 			} else {
 				std::cout << "flag: " << option << " is unknown\n"
 						<< " type -h to get options\n";
@@ -265,6 +455,7 @@ private:
 		noclean = false;
 		batch = 500000;
 		pthreads = 8;
+		mem = 1024;
 		lc_n = 30;
 		lc_mono = 50;
 		lc_di = 80;
@@ -273,13 +464,32 @@ private:
 		tasks = {0,1,2,3};
 
 		drm.perc_sim = 98;
+		drm.umi_in_name = false;
+		drm.umi_mm = 1;
+		drm.max_seed_frq = 0;
+		drm.stream = false;
+		drm.fp_bits = 16;
 		//drm.max_mismatch = 5;
 
+		prm.trim_adapter = false;
+
 		trm.min_match = 13;
 		trm.min_rlen = 70;
 		trm.min_qual = 2;
-
-		fe_k = 14;
+		trm.engine = "kmer";
+		trm.max_err = 2;
+		trm.win = 0;
+		trm.win_q = 20;
+
+		fe.k = 14;
+		fe.mode = "exact";
+		fe.depth = 4;
+		fe.bins = 64;
+		fe.tmp = ".";
+		fe.max_frq = 0;
+		fe.quantile = 0;
+
+		est_n = 100000;
 	}
 
 	void printUsage(char* exe) {
@@ -292,11 +502,12 @@ private:
 		std::cout << "-osfq: final output singleton fastq file\n";
 		std::cout << "-batch: default 500000; number of sequence (pairs) to be loaded in the memory (>=10000)";
 		std::cout << "-pthreads: default 8; number of cores to use\n";
+		std::cout << "-mem: default 1024; memory (MB) of fixed size structures in approximate modes\n";
 		std::cout << "-w, -w2: default 17, 5; sketching window sizes\n";
 		std::cout << "-lc_n, -lc_mono, -lc_di: default 30, 50, 80; defining low complexity sequence"
 				  << "\n\tmax percentage of ambiguous bases, mono nucleotides, and dinucleotides\n";
 		std::cout << "-tasks: default DupRm,Trim,PairedReadMerge,SFrqEst; "
-				"\n\ta list of comma separated tasks {DupRm, Trim, PairedReadMerge, SFrqEst}\n";
+				"\n\ta list of comma separated tasks {DupRm, Trim, PairedReadMerge, SFrqEst, DupEst}\n";
 		std::cout << "-silent: default false; no screen print-out\n";
 		std::cout << "-noclean: default false; do not remove intermediate files\n";
 		std::cout << std::endl;
@@ -306,12 +517,33 @@ private:
 		std::cout << "-drm_op: comma separated output paired fq files post dup rm\n";
 		std::cout << "-drm_perc_sim: default 98; percent similarity\n";
 		std::cout << "-drm_max_mismatch: default 5; max mismatches allowed\n";
+		std::cout << "-drm_umi: default none; 'name' to take UMIs from read names or\n"
+				  << "\tcomma separated index-read fq files storing UMIs, one per input pair;\n"
+				  << "\tfragments are only compared within the same UMI partition\n";
+		std::cout << "-drm_umi_mm: default 1 (<= 1); max mismatches between UMIs of a partition\n";
+		std::cout << "-drm_stream: default false; single pass approximate duplicate removal\n"
+				  << "\tusing a signature filter of -mem MB, not with -drm_umi or -drm_stats\n";
+		std::cout << "-drm_fp_bits: default 16; {8, 16, 32} filter fingerprint bits in -drm_stream,\n"
+				  << "\tmore bits lower the false positive rate\n";
+		std::cout << "-drm_max_seed_frq: default 0; seeds shared by more fragments are\n"
+				  << "\tnot used to form comparison buckets, 0 disables masking\n";
+		std::cout << "-drm_ibam: default none; query name grouped unaligned BAM input used\n"
+				  << "\tinstead of -ipfq, fragments are compared within a library only;\n"
+				  << "\tDupRm has to be the only task, -opfq and -osfq are not needed,\n"
+				  << "\t-drm_umi and -drm_stream are not supported\n";
+		std::cout << "-drm_obam: BAM output of -drm_ibam, all records of non-duplicate\n"
+				  << "\tread pairs are kept unchanged\n";
+		std::cout << "-drm_stats: default none; JSON file of per round clustering diagnostics\n"
+				  << "\t(bucket sizes, comparisons, unions, time), not in -drm_stream\n";
 		std::cout << std::endl;
 
 		/* paired read merging */
 		std::cout << "TASK: PairedReadMerge\n";
 		std::cout << "-prm_op: 2 comma separated output unmerged fq files\n";
 		std::cout << "-prm_os: merged single-end fq file\n";
+		std::cout << "-prm_trim_adapter: default false; when the overlap shows an insert\n"
+				  << "\tshorter than the reads, the adapter read-through outside the\n"
+				  << "\tinsert is trimmed off the merged read\n";
 		std::cout << std::endl;
 
 		/* trimming */
@@ -322,11 +554,51 @@ private:
 		std::cout << "-trm_min_match: default 13; min match b/t vector and a read to be trimmed\n";
 		std::cout << "-trm_min_rlen: default 70; min read length post-trimming\n";
 		std::cout << "-trm_q: default 2 (ASCII 35 #); min phred score (ASCII >= 33)\n";
+		std::cout << "-trm_engine: default kmer; primer matching engine, kmer: exact\n"
+				  << "\tkmer seeds extended by exact matches; myers: bit-parallel edit\n"
+				  << "\tdistance search of primers (first/last 64 bases) in reads, its\n"
+				  << "\tcost grows linearly with the number of primers\n";
+		std::cout << "-trm_max_err: default 2; max mismatches/indels of a primer\n"
+				  << "\tmatch (-trm_engine myers), scaled down for partial primers\n";
+		std::cout << "-trm_win: default 0 (off); sliding window size, a read is cut\n"
+				  << "\tbefore the first window with mean phred score < -trm_win_q\n";
+		std::cout << "-trm_win_q: default 20; min mean phred score of a window\n";
 		std::cout << std::endl;
 
 		/* sequence frequency estimate */
 		std::cout << "TASK: SFrqEst -- sequence frequency estimation\n";
-		std::cout << "-fe_k: default 14 (<= 16); substring length to calibrate\n";
+		std::cout << "-fe_k: default 14 (<= 32); substring length to calibrate\n";
+		std::cout << "-fe_mode: default exact; {exact, cms, disk} count k-mers exactly,\n"
+				  << "\tapproximately in a count-min sketch of -mem MB, which never\n"
+				  << "\tunderestimates and bounds memory on large libraries, or exactly\n"
+				  << "\tout of core in -fe_bins minimiser partitioned bins on disk\n";
+		std::cout << "-fe_depth: default 4 (<= 16); rows of the sketch in -fe_mode cms,\n"
+				  << "\tmore rows lower the probability of exceeding the error bound\n";
+		std::cout << "-fe_bins: default 64 (<= 512); on-disk bins in -fe_mode disk, peak\n"
+				  << "\tmemory is bounded by the k-mers of the largest bin\n";
+		std::cout << "-fe_tmp: default .; directory of temporary files in -fe_mode disk\n";
+		std::cout << "-fe_db_out: default none; write the k-mer counts to a binary file\n"
+				  << "\t(-fe_mode exact or disk)\n";
+		std::cout << "-fe_db_in: default none; score reads against the k-mer counts of\n"
+				  << "\ta -fe_db_out file instead of counting, k is taken from the file\n";
+		std::cout << "-fe_op, -fe_os: default none; output fq files of kept pairs (2 files)\n"
+				  << "\tand kept single end reads; a pair is filtered if either read is\n";
+		std::cout << "-fe_filtered: default none; prefix of the fq files of filtered reads,\n"
+				  << "\t<prefix>_1.fq, <prefix>_2.fq and <prefix>_s.fq\n";
+		std::cout << "-fe_max_frq: default 0 (no threshold); reads of higher frequency are\n"
+				  << "\tfiltered\n";
+		std::cout << "-fe_quantile: default 0 (off); e.g. 99.9, reads of frequency above\n"
+				  << "\tthis percentile are filtered, overrides -fe_max_frq\n";
+		std::cout << "-fe_frq_out: default none; binary file of read frequencies, one\n"
+				  << "\tint32 per read in the order of the input files\n";
+		std::cout << std::endl;
+
+		/* duplicate rate estimate */
+		std::cout << "TASK: DupEst -- duplicate rate estimation from a subsample\n";
+		std::cout << "-est_n: default 100000 (>= 1000); number of pairs sampled\n";
+		std::cout << "\t(no reads are written, -opfq and -osfq are not needed if\n"
+				  << "\tDupEst is the only task)\n";
+		std::cout << "\t(-drm_perc_sim is used as the similarity criterion)\n";
 		std::cout << std::endl;
 
 		std::cout << "----------------------------------------------------------\n";
@@ -355,10 +627,23 @@ private:
 			print_file_list (header + " -ipfq ", ipfq);
 			print_file_list (header + " -isfq ", isfq);
 			print_file_list (header + " -fa ", ifa);
-			if (opfq.size() != 2) abording ("-opfq not not specified\n type -h to get options");
-			print_file_list (header + " -opfq ", opfq);
-			if (osfq.empty()) abording ("-osfq not not specified\n type -h to get options");
-			std::cout << header << " -osfq " << osfq;
+			if (drm.ibam.size()) {
+				if (tasks.size() != 1 || tasks[0] != DupRm) {
+					abording ("-drm_ibam: DupRm should be the only task\n type -h to get options");
+				}
+				if (drm.obam.empty()) abording ("-drm_obam not specified\n type -h to get options");
+				if (drm.umi_in_name || drm.umi_fq.size()) {
+					abording ("-drm_ibam does not support -drm_umi\n type -h to get options");
+				}
+				if (drm.stream) {
+					abording ("-drm_ibam does not support -drm_stream\n type -h to get options");
+				}
+			} else if (writes_fq ()) {
+				if (opfq.size() != 2) abording ("-opfq not not specified\n type -h to get options");
+				print_file_list (header + " -opfq ", opfq);
+				if (osfq.empty()) abording ("-osfq not not specified\n type -h to get options");
+				std::cout << header << " -osfq " << osfq;
+			}
 			std::cout << header << " -batch " << batch << header << " -pthreads "
 					<< pthreads << header << " -w " << w << header << " -w2 " << w2
 					<< header << " -lc_n " << lc_n << header << " -lc_mono " << lc_mono
@@ -370,11 +655,31 @@ private:
 				case DupRm:
 					if (mytask.empty()) 	mytask += "DupRm";
 					else mytask += ",DupRm";
-					if (drm.op.size() == 0) {
+					if (drm.ibam.size()) {
+						std::cout << header << " -drm_ibam " << drm.ibam << header
+								<< " -drm_obam " << drm.obam;
+					} else if (drm.op.size() == 0) {
 						abording ("Task DupRm: -drm_op not specified\n type -h to get options");
 					}
 					print_file_list (header + " -drm_op ", drm.op);
 					std::cout << header << " -drm_perc_sim " << drm.perc_sim;
+					std::cout << header << " -drm_max_seed_frq " << drm.max_seed_frq;
+					if (drm.stats.size()) std::cout << header << " -drm_stats " << drm.stats;
+					if (drm.umi_in_name) std::cout << header << " -drm_umi name";
+					else print_file_list (header + " -drm_umi ", drm.umi_fq);
+					if (drm.umi_in_name || drm.umi_fq.size()) {
+						std::cout << header << " -drm_umi_mm " << drm.umi_mm;
+					}
+					if (drm.stream) {
+						if (drm.umi_in_name || drm.umi_fq.size()) {
+							abording ("Task DupRm: -drm_stream does not support -drm_umi\n type -h to get options");
+						}
+						if (drm.stats.size()) {
+							abording ("Task DupRm: -drm_stream does not support -drm_stats\n type -h to get options");
+						}
+						std::cout << header << " -drm_stream" << header << " -mem "
+								<< mem << header << " -drm_fp_bits " << drm.fp_bits;
+					}
 					//std::cout << header << " -drm_max_mismatch " << drm.max_mismatch;
 					break;
 				case PairedReadMerge:
@@ -387,6 +692,7 @@ private:
 					}
 					std::cout << header << " -prm_op " << prm.op.first << "," << prm.op.second;
 					std::cout << header << " -prm_os " << prm.os;
+					if (prm.trim_adapter) std::cout << header << " -prm_trim_adapter";
 					break;
 				case Trim:
 					if (mytask.empty()) 	mytask += "Trim";
@@ -401,11 +707,50 @@ private:
 					std::cout << header << " -trm_min_match " << trm.min_match;
 					std::cout << header << " -trm_min_rlen " << trm.min_rlen;
 					std::cout << header << " -trm_q " << trm.min_qual;
+					std::cout << header << " -trm_engine " << trm.engine;
+					if (trm.engine == "myers") {
+						std::cout << header << " -trm_max_err " << trm.max_err;
+					}
+					if (trm.win > 0) {
+						std::cout << header << " -trm_win " << trm.win;
+						std::cout << header << " -trm_win_q " << trm.win_q;
+					}
 					break;
 				case SFrqEst:
 					if (mytask.empty()) 	mytask += "SFrqEst";
 					else mytask += ",SFrqEst";
-					std::cout << header << " -fe_k " << fe_k;
+					if (fe.db_in.size()) {
+						std::cout << header << " -fe_db_in " << fe.db_in;
+					} else {
+						std::cout << header << " -fe_k " << fe.k;
+						std::cout << header << " -fe_mode " << fe.mode;
+						if (fe.db_out.size()) std::cout << header << " -fe_db_out " << fe.db_out;
+						if (fe.mode == "cms") {
+							std::cout << header << " -mem " << mem
+									<< header << " -fe_depth " << fe.depth;
+						} else if (fe.mode == "disk") {
+							std::cout << header << " -fe_bins " << fe.bins
+									<< header << " -fe_tmp " << fe.tmp;
+						}
+					}
+					if (fe.op.size() && fe.os.empty()) {
+						std::cout << std::endl;
+						abording ("Task SFrqEst: -fe_op requires -fe_os\n type -h to get options");
+					}
+					if (fe.op.size()) {
+						print_file_list (header + " -fe_op ", fe.op);
+						std::cout << header << " -fe_os " << fe.os;
+					}
+					if (fe.filtered.size()) std::cout << header << " -fe_filtered " << fe.filtered;
+					if (fe.quantile > 0) std::cout << header << " -fe_quantile " << fe.quantile;
+					else if (fe.max_frq > 0) std::cout << header << " -fe_max_frq " << fe.max_frq;
+					if (fe.frq_out.size()) std::cout << header << " -fe_frq_out " << fe.frq_out;
+					break;
+				case DupEst:
+					if (mytask.empty()) 	mytask += "DupEst";
+					else mytask += ",DupEst";
+					std::cout << header << " -est_n " << est_n;
+					std::cout << header << " -drm_perc_sim " << drm.perc_sim;
 					break;
 				}
 			}
@@ -19,43 +19,261 @@
 #include "SeqFrqEst.h"
 
 /* @brief	Given a list of paired fastq files [ipfq] and unpaired fastq
- * 	files [isfq], the kmer size [k] estimate the frequency of each input
- * 	read
+ * 	files [isfq], the kmer size [fe.k] estimate the frequency of each input
+ * 	read; k-mers are counted exactly, in a count-min sketch of [mem] MB
+ * 	(-fe_mode cms) or out of core in minimiser partitioned bins (-fe_mode
+ * 	disk), or loaded from a k-mer count file [fe.db_in]
  */
 void estSeqFrq (const strvec_t& ipfq, const strvec_t& isfq,
-		int k, int batch, bool silent){
+		const fe_t& fe, int batch, int mem, bool silent){
 
 	strvec_t myfiles = ipfq;
 	myfiles.insert(myfiles.end(), isfq.begin(), isfq.end());
 
-	if (! silent) std::cout << "\tobtain " << k << "-mer frequency\n";
-	umap_t kcnt;
-	obtain_kfrq (kcnt, k, batch, myfiles, silent);
+	if (fe.db_in.size()) {
+		xny::kmer_db kcnt;
+		if (! kcnt.open (fe.db_in)) {
+			abording ("SFrqEst: " + fe.db_in + " is not a k-mer count file");
+		}
+		if (! kcnt.canonical()) {
+			abording ("SFrqEst: " + fe.db_in + " does not hold canonical k-mers");
+		}
+		if (! silent) {
+			std::cout << "\tload " << kcnt.k() << "-mer frequency: " << fe.db_in
+				<< "\n\t\t" << kcnt.size() << " kmers, total count "
+				<< kcnt.total() << "\n";
+		}
+		kmer_fn_t get_kmers = xny::select_kmer_kernel<kmer_kernel_t> (kcnt.k());
 
-	if (! silent) std::cout << "\tnumer of kmers: " << kcnt.size() << "\n";
+		ivec_t frq;
+		u64vec_t nreads;
+		obtain_seqfrq (frq, nreads, kcnt, get_kmers, batch, myfiles, silent);
+		output_seqfrq (frq, nreads, ipfq, isfq, fe, silent);
+		return;
+	}
 
-	ivec_t frq;
-	obtain_seqfrq (frq, kcnt, k, batch, myfiles, silent);
+	if (! silent) std::cout << "\tobtain " << fe.k << "-mer frequency\n";
+	// the kernel for k is selected once for the whole run
+	kmer_fn_t get_kmers = xny::select_kmer_kernel<kmer_kernel_t> (fe.k);
+	if (get_kmers == NULL) abording ("SFrqEst: k-mer size out of [1, 32]");
 
+	ivec_t frq;
+	u64vec_t nreads;
+	if (fe.mode == "cms") {
+		if (fe.db_out.size()) {
+			warning ("-fe_db_out is ignored in -fe_mode cms, the sketch does"
+					" not keep the k-mers");
+		}
+		// the widest sketch of fe.depth rows fitting in mem MB
+		uint64_t width = 1;
+		while (2 * width * fe.depth * sizeof (uint32_t) <= ((uint64_t) mem << 20)) {
+			width *= 2;
+		}
+		ksketch_t kcnt (width, fe.depth);
+		uint64_t total = obtain_kfrq (kcnt, get_kmers, batch, myfiles, silent);
+
+		if (! silent) {
+			std::cout << "\tcount-min sketch: " << kcnt.bytes() / (1 << 20)
+				<< " MB, " << kcnt.depth() << " x " << kcnt.width()
+				<< " counters, " << total << " kmers added\n";
+			std::cout << "\t\tkmer and read frequencies are overestimated by at"
+				<< " most " << kcnt.epsilon() * total << " with probability "
+				<< 1 - kcnt.delta() << "\n";
+		}
 
-	{ // debug
-		std::cout << kcnt.size() << " kmers observed\n";
-		uvec_t kfrq;
-		for (auto & x: kcnt) { kfrq.push_back(x.second); }
-		std::sort (kfrq.begin(), kfrq.end());
-		for (uvec_t::reverse_iterator it = kfrq.rbegin(); it != kfrq.rend(); ++ it) {
-			std::cout << *it << "\t";
+		obtain_seqfrq (frq, nreads, kcnt, get_kmers, batch, myfiles, silent);
+	} else if (fe.mode == "disk") {
+		std::string db = fe.db_out.size() ? fe.db_out : fe.tmp + "/sfrq_kmers.db";
+		{
+			kmer_bins_t bins (fe.k, fe.bins, fe.tmp);
+			obtain_kfrq (bins, get_kmers, batch, myfiles, silent);
+			count_kmer_bins (bins, get_kmers, fe.k, db, silent);
 		}
-		std::cout<< "\n\n";
-		std::cout << "# reads " << frq.size() << "\n";
-		for (auto & x: frq) std::cout << x << "\n";
+
+		xny::kmer_db kcnt;
+		if (! kcnt.open (db)) abording ("SFrqEst: cannot read " + db);
+		if (! silent) std::cout << "\tnumer of kmers: " << kcnt.size() << "\n";
+
+		obtain_seqfrq (frq, nreads, kcnt, get_kmers, batch, myfiles, silent);
+		kcnt.close ();
+		if (fe.db_out.empty()) std::remove (db.c_str());
+	} else {
+		kcnt_t kcnt;
+		obtain_kfrq (kcnt, get_kmers, batch, myfiles, silent);
+
+		if (! silent) std::cout << "\tnumer of kmers: " << kcnt.size() << "\n";
+		if (fe.db_out.size()) write_kmer_db (fe.db_out, kcnt, fe.k);
+
+		obtain_seqfrq (frq, nreads, kcnt, get_kmers, batch, myfiles, silent);
 	}
+
+	output_seqfrq (frq, nreads, ipfq, isfq, fe, silent);
 } // estSeqFrq
 
-/* @brief	Estimate sequence frequency for all reads in fastq files
+/* @brief	Output stage of the read frequencies [frq] of the reads of
+ * 	[ipfq] and [isfq], [nreads] per file:
+ * 	-- a histogram summary (not silent)
+ * 	-- the frequencies as int32_t in input order to [fe.frq_out]
+ * 	-- reads with frequency <= threshold to [fe.op] and [fe.os], others
+ * 	   to [fe.filtered]_1.fq, _2.fq and _s.fq; a pair is filtered if
+ * 	   either read is
+ */
+void output_seqfrq (const ivec_t& frq, const u64vec_t& nreads,
+		const strvec_t& ipfq, const strvec_t& isfq, const fe_t& fe,
+		bool silent) {
+
+	// threshold: quantile of the read frequencies or fixed
+	int threshold = fe.max_frq > 0 ? fe.max_frq : INT_MAX;
+	if (fe.quantile > 0 && frq.size()) {
+		ivec_t sorted = frq;
+		size_t q = std::min (sorted.size() - 1,
+				(size_t) (fe.quantile / 100 * sorted.size()));
+		std::nth_element (sorted.begin(), sorted.begin() + q, sorted.end());
+		threshold = sorted[q];
+	}
+
+	if (fe.frq_out.size()) {
+		std::ofstream fh (fe.frq_out.c_str(), std::ios::binary);
+		for (auto& x: frq) {
+			int32_t f = x;
+			fh.write ((const char*) &f, sizeof (f));
+		}
+		if (! fh.good()) abording ("SFrqEst: cannot write " + fe.frq_out);
+	}
+
+	if (! silent) print_frq_histogram (frq, threshold);
+
+	if (fe.op.empty()) return;
+
+	std::ofstream ofh, ofh2, ofhs, ffh, ffh2, ffhs;
+	xny::openfile<std::ofstream> (ofh, fe.op[0]);
+	xny::openfile<std::ofstream> (ofh2, fe.op[1]);
+	xny::openfile<std::ofstream> (ofhs, fe.os);
+	if (fe.filtered.size()) {
+		xny::openfile<std::ofstream> (ffh, fe.filtered + "_1.fq");
+		xny::openfile<std::ofstream> (ffh2, fe.filtered + "_2.fq");
+		xny::openfile<std::ofstream> (ffhs, fe.filtered + "_s.fq");
+	}
+	auto write_fq = [] (std::ofstream& fh, const fqtuple_t& r) {
+		fh << "@" << std::get<0>(r) << "\n" << std::get<1>(r) << "\n+\n"
+			<< std::get<2>(r) << "\n";
+	};
+
+	uint64_t off = 0, num_kept = 0, num_filtered = 0;
+	for (int i = 0; i < (int) ipfq.size(); i += 2) {
+		if (nreads[i] != nreads[i + 1]) {
+			abording ("SFrqEst: " + ipfq[i] + " and " + ipfq[i + 1] +
+					" hold different numbers of reads");
+		}
+		std::ifstream ifh, ifh2;
+		xny::openfile<std::ifstream> (ifh, ipfq[i]);
+		xny::openfile<std::ifstream> (ifh2, ipfq[i + 1]);
+		bio::fastq_input_iterator<> fq (ifh), fq2 (ifh2), end;
+		for (uint64_t j = 0; j < nreads[i]; ++ j, ++ fq, ++ fq2) {
+			if (std::max (frq[off + j], frq[off + nreads[i] + j]) <= threshold) {
+				write_fq (ofh, *fq);
+				write_fq (ofh2, *fq2);
+				num_kept += 2;
+			} else {
+				if (ffh.is_open()) {
+					write_fq (ffh, *fq);
+					write_fq (ffh2, *fq2);
+				}
+				num_filtered += 2;
+			}
+		}
+		off += 2 * nreads[i];
+	}
+	for (int i = 0; i < (int) isfq.size(); ++ i) {
+		std::ifstream ifh;
+		xny::openfile<std::ifstream> (ifh, isfq[i]);
+		bio::fastq_input_iterator<> fq (ifh), end;
+		uint64_t j = 0;
+		for (; j < nreads[ipfq.size() + i]; ++ j, ++ fq) {
+			if (frq[off + j] <= threshold) {
+				write_fq (ofhs, *fq);
+				++ num_kept;
+			} else {
+				if (ffhs.is_open()) write_fq (ffhs, *fq);
+				++ num_filtered;
+			}
+		}
+		off += j;
+	}
+
+	if (! silent) {
+		std::cout << "\t\t" << num_kept << " reads kept, " << num_filtered
+			<< " reads filtered\n";
+	}
+} // output_seqfrq
+
+/* @brief	Print the number of reads per frequency range [2^i, 2^(i+1)),
+ * 	(0 apart), and the number above [threshold]
+ */
+void print_frq_histogram (const ivec_t& frq, int threshold) {
+	uvec_t hist;
+	uint64_t above = 0;
+	for (auto& f: frq) {
+		int b = 0;
+		while (b < 31 && ((int64_t) 1 << b) <= f) ++ b;
+		if (b >= (int) hist.size()) hist.resize (b + 1, 0);
+		++ hist[b];
+		if (f > threshold) ++ above;
+	}
+
+	std::cout << "\tread frequency histogram (" << frq.size() << " reads)\n";
+	std::ios::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	for (int b = 0; b < (int) hist.size(); ++ b) {
+		if (hist[b] == 0) continue;
+		std::cout << "\t\t";
+		if (b == 0) std::cout << "0";
+		else if (b == 1) std::cout << "1";
+		else std::cout << (1 << (b - 1)) << "-" << (1 << b) - 1;
+		std::cout << "\t" << hist[b] << "\t" << std::fixed
+			<< std::setprecision(2) << 100.0 * hist[b] / frq.size()
+			<< "%\n";
+	}
+	std::cout.flags (flags);
+	std::cout.precision (precision);
+	if (threshold != INT_MAX) {
+		std::cout << "\t\tthreshold " << threshold << ": " << above
+			<< " reads above\n";
+	}
+} // print_frq_histogram
+
+/* @brief	Write the k-mer counts [kcnt] to the k-mer count file [db]
+ */
+void write_kmer_db (const std::string& db, const kcnt_t& kcnt, int k) {
+	u64vec_t keys;
+	keys.reserve (kcnt.size());
+	for (uint64_t s = 0; s < kcnt.capacity(); ++ s) {
+		if (kcnt.key(s) != kcnt_t::empty_key) keys.push_back (kcnt.key(s));
+	}
+	std::sort (keys.begin(), keys.end());
+
+	xny::kmer_db_writer out (db, k, true, keys.size());
+	for (auto& key: keys) out.add (key, kcnt.count (key));
+	if (! out.close()) abording ("SFrqEst: cannot write " + db);
+} // write_kmer_db
+
+/* @brief	Distinct k-mers [kIDs] of sequence [seq]
  */
-void obtain_seqfrq (ivec_t& frq, const umap_t& kcnt,
-		int k, int batch, const strvec_t& files, bool silent) {
+static void distinct_kmers (u64vec_t& kIDs, const std::string& seq,
+		kmer_fn_t get_kmers) {
+	kIDs.clear();
+	get_kmers (seq.data(), seq.length(), std::back_inserter(kIDs));
+	std::sort (kIDs.begin(), kIDs.end());
+	kIDs.erase (std::unique (kIDs.begin(), kIDs.end()), kIDs.end());
+} // distinct_kmers
+
+/* @brief	Estimate sequence frequency for all reads in fastq files,
+ * 	[nreads]: number of reads per file
+ */
+template <typename counter_t>
+void obtain_seqfrq (ivec_t& frq, u64vec_t& nreads, const counter_t& kcnt,
+		kmer_fn_t get_kmers, int batch, const strvec_t& files, bool silent) {
+	nreads.assign (files.size(), 0);
 	strvec_t seqs;
 	int cnt = batch, total_reads = 0;
 	for (int i = 0; i < (int) files.size(); ++ i) {
@@ -69,11 +287,13 @@ void obtain_seqfrq (ivec_t& frq, const umap_t& kcnt,
 
 		while (fq != end) {
 
+			size_t num_seqs = seqs.size();
 			add_fq_reads_only (seqs, cnt, fq, end);
+			nreads[i] += seqs.size() - num_seqs;
 
 			if ((int) seqs.size() >= batch) {
 				total_reads += seqs.size();
-				seq_freq (frq, kcnt, k, seqs);
+				seq_freq (frq, kcnt, get_kmers, seqs);
 				cnt = batch;
 				seqs.clear();
 			} else { // not enough reads to fill in batch for current file pair
@@ -83,62 +303,43 @@ void obtain_seqfrq (ivec_t& frq, const umap_t& kcnt,
 		} // while
 	} // for
 	total_reads += seqs.size();
-	seq_freq (frq, kcnt, k, seqs);
+	seq_freq (frq, kcnt, get_kmers, seqs);
 	if (!silent) std::cout << "\t\t" << total_reads << " reads analyzed\n";
 
 } // obtain_seqfrq
 
 /* @brief	Adding frequency of sequences [seqs] to vector [frq]
  */
-void seq_freq (ivec_t& frq, const umap_t& kcnt,
-		int k, const strvec_t& seqs) {
+template <typename counter_t>
+void seq_freq (ivec_t& frq, const counter_t& kcnt,
+		kmer_fn_t get_kmers, const strvec_t& seqs) {
 
 	int sz = seqs.size();
 	ivec_t local_frq (sz, 0);
-//	int total_debug = 0;
-	#pragma omp parallel for
+	u64vec_t kIDs;
+	#pragma omp parallel for private (kIDs)
 	for (int i = 0; i < sz; ++ i) {
-		int frq_sum = 0;
-		uvec_t kIDs;
-		xny::get_bitkmer<std::back_insert_iterator<uvec_t>, uint32_t>
-				(seqs[i], std::back_inserter(kIDs), k, 0);
-		uset_t kID_set (kIDs.begin(), kIDs.end());
-
-		for (auto& id: kID_set) {
-			umap_t::const_iterator it = kcnt.find(id);
-			if (it != kcnt.end()) frq_sum += it->second;
-		}
-		if (kID_set.size() != 0) {
-			local_frq[i] = frq_sum / kID_set.size();
-
-			{ // debug
-				if (local_frq[i] > 1000) {
-					std::cout << ">" << i << "\n" <<  seqs[i] << "\n";
-					/*
-					uvec_t cnts;
-					for (auto& id: kIDs) {
-						int cnt = kcnt.find(id)->second;
-						std::cout << cnt << ", ";
-						cnts.push_back(cnt);
-					}
-					std::cout << "\n";
-					std::sort (cnts.begin(), cnts.end());
-					for (auto& x : cnts) std::cout << x << ", ";
-					std::cout << "\n\n";
-					*/
-				}
-			}
+		int64_t frq_sum = 0;
+		distinct_kmers (kIDs, seqs[i], get_kmers);
+
+		for (auto& id: kIDs) {
+			frq_sum += kmer_frq (kcnt, id);
+		}
+		if (kIDs.size() != 0) {
+			local_frq[i] = frq_sum / (int64_t) kIDs.size();
 		}
 	}
 	frq.insert(frq.end(), local_frq.begin(), local_frq.end());
-//	std::cout << "total debug = " << total_debug << "\n";
 } // seq_freq
 
-/* @brief	Obtain kmer frequency in a given set of fastq files
+/* @brief	Obtain kmer frequency in a given set of fastq files, return
+ * 	the number of k-mers added (distinct ones per read)
  */
-void obtain_kfrq (umap_t& kcnt, int k, int batch,
+template <typename counter_t>
+uint64_t obtain_kfrq (counter_t& kcnt, kmer_fn_t get_kmers, int batch,
 		const strvec_t& files, bool silent) {
 
+	uint64_t total_kmers = 0;
 	strvec_t seqs;
 	int cnt = batch, total_reads = 0;
 	for (int i = 0; i < (int) files.size(); ++ i) {
@@ -156,7 +357,7 @@ void obtain_kfrq (umap_t& kcnt, int k, int batch,
 
 			if ((int) seqs.size() >= batch) {
 				total_reads += seqs.size();
-				kmer_cnt_in_seqs (kcnt, seqs, k);
+				total_kmers += kmer_cnt_in_seqs (kcnt, seqs, get_kmers);
 				cnt = batch;
 				seqs.clear();
 			} else { // not enough reads to fill in batch for current file
@@ -166,40 +367,209 @@ void obtain_kfrq (umap_t& kcnt, int k, int batch,
 		} // while
 	} // for
 	total_reads += seqs.size();
-	kmer_cnt_in_seqs (kcnt, seqs, k);
+	total_kmers += kmer_cnt_in_seqs (kcnt, seqs, get_kmers);
 
 	if (!silent) std::cout << "\t\t" << total_reads << " reads analyzed\n";
+	return total_kmers;
 } // obtain_kfrq
 
-/* @brief	Count kmers in a given set of sequences [seqs]
+/* @brief	Count kmers in a given set of sequences [seqs], return the
+ * 	number of k-mers added
+ */
+uint64_t kmer_cnt_in_seqs (kcnt_t& kcnt, const strvec_t& seqs,
+		kmer_fn_t get_kmers){
+	int sz = seqs.size();
+	uint64_t added = 0;
+
+	// room for new k-mers: a fraction of the bases of the batch, a read
+	// whose k-mers do not all fit is resumed after the table grows
+	uint64_t num_bases = 0;
+	for (int i = 0; i < sz; ++ i) num_bases += seqs[i].length();
+	kcnt.reserve (num_bases / 16);
+
+	ivec_t pending (sz), resume (sz, 0); // index of the first k-mer not added
+	for (int i = 0; i < sz; ++ i) pending[i] = i;
+	while (! pending.empty()) {
+		int num_pending = pending.size();
+		#pragma omp parallel
+		{
+			u64vec_t kIDs;
+
+			#pragma omp for reduction (+:added)
+			for (int x = 0; x < num_pending; ++ x) {
+				int i = pending[x];
+				distinct_kmers (kIDs, seqs[i], get_kmers);
+
+				int j = resume[i];
+				while (j < (int) kIDs.size() && kcnt.add (kIDs[j])) ++ j;
+				added += j - resume[i];
+				resume[i] = (j == (int) kIDs.size()) ? -1 : j;
+			}
+		} // #pragma omp parallel
+
+		int num_left = 0;
+		for (int x = 0; x < num_pending; ++ x) {
+			if (resume[pending[x]] != -1) pending[num_left ++] = pending[x];
+		}
+		pending.resize (num_left);
+		if (num_left) kcnt.reserve (kcnt.size()); // double the table
+	}
+	return added;
+} // kmer_cnt_in_seqs
+
+/* @brief	Add kmers in a given set of sequences [seqs] to the sketch
+ * 	[kcnt] by conservative update, return the number of k-mers added
  */
-void kmer_cnt_in_seqs (umap_t& kcnt, const strvec_t& seqs, int k){
+uint64_t kmer_cnt_in_seqs (ksketch_t& kcnt, const strvec_t& seqs,
+		kmer_fn_t get_kmers){
 	int sz = seqs.size();
+	uint64_t added = 0;
 	#pragma omp parallel
 	{
-		umap_t local_kcnt; // private to each thread
+		u64vec_t kIDs;
+
+		#pragma omp for reduction (+:added)
+		for (int i = 0; i < sz; ++ i) {
+			distinct_kmers (kIDs, seqs[i], get_kmers);
+			for (auto& id: kIDs) kcnt.add_conservative (id);
+			added += kIDs.size();
+		}
+	} // #pragma omp parallel
+	return added;
+} // kmer_cnt_in_seqs
+
+/* @brief	Append the super-k-mers of sequences [seqs] to the on-disk bins
+ * 	[bins]; k-mers are only counted by count_kmer_bins (), return 0
+ */
+uint64_t kmer_cnt_in_seqs (kmer_bins_t& bins, const strvec_t& seqs,
+		kmer_fn_t) {
+	int sz = seqs.size(), num_bins = bins.part.bins();
+	std::vector<strvec_t> bufs (omp_get_max_threads(), strvec_t (num_bins));
+	xny::superkmer_partitioner part = bins.part;
+	#pragma omp parallel firstprivate (part)
+	{
+		strvec_t& buf = bufs[omp_get_thread_num()];
 
 		#pragma omp for
 		for (int i = 0; i < sz; ++ i) {
-			uvec_t kIDs;
-			xny::get_bitkmer<std::back_insert_iterator<uvec_t>, uint32_t>
-				(seqs[i], std::back_inserter(kIDs), k, 0);
-			uset_t kID_set (kIDs.begin(), kIDs.end());
-
-			for (auto& id: kID_set) {
-				umap_t::iterator it = local_kcnt.find(id);
-				if (it != local_kcnt.end()) ++ it->second;
-				else local_kcnt[id] = 1;
-			}
+			part.add (seqs[i].data(), seqs[i].length(), buf);
 		}
-		#pragma omp critical
-		{
-			for (auto& kc: local_kcnt) {
-				umap_t::iterator it = kcnt.find(kc.first);
-				if (it != kcnt.end()) it->second += kc.second;
-				else kcnt.insert(kc);
+	} // #pragma omp parallel
+
+	for (int b = 0; b < num_bins; ++ b) {
+		for (auto& buf: bufs) bins.fhs[b].write (buf[b].data(), buf[b].size());
+		if (! bins.fhs[b].good()) abording ("SFrqEst: cannot write " + bins.files[b]);
+	}
+	return 0;
+} // kmer_cnt_in_seqs
+
+/* @brief	Count the k-mers of each bin of [bins] in memory, in parallel,
+ * 	and merge the sorted counts into the k-mer count file [db]; the bin
+ * 	files are removed. Return the number of k-mers added (distinct ones
+ * 	per read).
+ */
+uint64_t count_kmer_bins (kmer_bins_t& bins, kmer_fn_t get_kmers, int k,
+		const std::string& db, bool silent) {
+	int num_bins = bins.files.size();
+	for (auto& fh: bins.fhs) fh.close();
+
+	// sorted (k-mer, count) runs, one per bin
+	strvec_t runs (num_bins);
+	u64vec_t run_size (num_bins, 0);
+	uint64_t total = 0;
+	#pragma omp parallel
+	{
+		strvec_t sks;
+		u64vec_t kIDs;
+		std::vector<std::pair<uint64_t, uint32_t> > kcs;
+
+		#pragma omp for schedule (dynamic) reduction (+:total)
+		for (int b = 0; b < num_bins; ++ b) {
+			std::string buf;
+			{
+				std::ifstream fh (bins.files[b].c_str(), std::ios::binary);
+				buf.assign (std::istreambuf_iterator<char>(fh),
+						std::istreambuf_iterator<char>());
+			}
+			std::remove (bins.files[b].c_str());
+
+			kcnt_t kcnt (buf.size() / 8);
+			size_t pos = 0;
+			while (xny::superkmer_partitioner::next_group (buf, pos, sks)) {
+				kIDs.clear();
+				for (auto& sk: sks) {
+					get_kmers (sk.data(), sk.length(), std::back_inserter(kIDs));
+				}
+				std::sort (kIDs.begin(), kIDs.end());
+				kIDs.erase (std::unique (kIDs.begin(), kIDs.end()), kIDs.end());
+				for (auto& id: kIDs) {
+					if (! kcnt.add (id)) { // serial use, grow in place
+						kcnt.reserve (kcnt.size());
+						kcnt.add (id);
+					}
+				}
+				total += kIDs.size();
 			}
+			buf.clear();
+
+			kcs.clear();
+			for (uint64_t s = 0; s < kcnt.capacity(); ++ s) {
+				if (kcnt.key(s) != kcnt_t::empty_key) {
+					kcs.push_back (std::make_pair (kcnt.key(s), kcnt.count_at(s)));
+				}
+			}
+			std::sort (kcs.begin(), kcs.end());
+			runs[b] = bins.files[b] + ".cnt";
+			std::ofstream fh (runs[b].c_str(), std::ios::binary);
+			for (auto& kc: kcs) {
+				fh.write ((const char*) &kc.first, sizeof (kc.first));
+				fh.write ((const char*) &kc.second, sizeof (kc.second));
+			}
+			if (! fh.good()) abording ("SFrqEst: cannot write " + runs[b]);
+			run_size[b] = kcs.size();
 		}
 	} // #pragma omp parallel
 
-} // kmer_cnt_in_seqs
+	// merge, bins hold disjoint k-mers
+	uint64_t num_kmers = 0, max_bin = 0;
+	for (auto& x: run_size) {
+		num_kmers += x;
+		max_bin = std::max (max_bin, x);
+	}
+	xny::kmer_db_writer out (db, k, true, num_kmers);
+	if (! out.good()) abording ("SFrqEst: cannot write " + db);
+
+	std::vector<std::ifstream> ins (num_bins);
+	uvec_t cnts (num_bins);
+	typedef std::pair<uint64_t, int> kmer_run_t;
+	std::priority_queue<kmer_run_t, std::vector<kmer_run_t>,
+		std::greater<kmer_run_t> > heads;
+	auto next = [&] (int b) {
+		uint64_t key;
+		if (ins[b].read ((char*) &key, sizeof (key)) &&
+				ins[b].read ((char*) &cnts[b], sizeof (cnts[b]))) {
+			heads.push (kmer_run_t (key, b));
+		}
+	};
+	for (int b = 0; b < num_bins; ++ b) {
+		ins[b].open (runs[b].c_str(), std::ios::binary);
+		next (b);
+	}
+	while (! heads.empty()) {
+		kmer_run_t h = heads.top();
+		heads.pop();
+		out.add (h.first, cnts[h.second]);
+		next (h.second);
+	}
+	for (int b = 0; b < num_bins; ++ b) {
+		ins[b].close();
+		std::remove (runs[b].c_str());
+	}
+	if (! out.close()) abording ("SFrqEst: cannot write " + db);
+
+	if (! silent) {
+		std::cout << "\t\t" << num_bins << " bins, largest " << max_bin
+			<< " kmers\n";
+	}
+	return total;
+} // count_kmer_bins
@@ -19,21 +19,83 @@
 #ifndef SEQFRQEST_H_
 #define SEQFRQEST_H_
 
+#include <queue>
+#include <functional>
 #include "xutil.h"
+#include "Parameter.h"
 #include "ReadBioFile.h"
 #include "jaz/fastx_iterator.hpp"
 #include "xny/seq_manip.hpp"
 #include "xny/file_manip.hpp"
+#include "xny/kmer_counter.hpp"
+#include "xny/count_min_sketch.hpp"
+#include "xny/superkmer.hpp"
+#include "xny/kmer_db.hpp"
 
-void estSeqFrq (const strvec_t& ipfqlist, const strvec_t& isfqlist,
-		int k, int batch, bool silent);
+/* canonical (smaller strand) k-mer, k <= 32 -> count */
+typedef xny::kmer_counter kcnt_t;
+
+/* approximate k-mer counts of bounded memory, -fe_mode cms */
+typedef xny::count_min_sketch ksketch_t;
+
+inline uint32_t kmer_frq (const kcnt_t& kcnt, uint64_t id) {
+	return kcnt.count (id);
+}
+inline uint32_t kmer_frq (const ksketch_t& kcnt, uint64_t id) {
+	return kcnt.estimate (id);
+}
+inline uint32_t kmer_frq (const xny::kmer_db& kcnt, uint64_t id) {
+	return kcnt.count (id);
+}
+
+/* k-mers of all reads partitioned by minimiser into on-disk bins,
+ * -fe_mode disk; counted by count_kmer_bins () */
+struct kmer_bins_t {
+	xny::superkmer_partitioner part;
+	strvec_t files;
+	std::vector<std::ofstream> fhs;
 
-void obtain_kfrq (umap_t& kcnt, int k, int batch, const strvec_t& files, bool silent);
-void kmer_cnt_in_seqs (umap_t& kcnt,	const strvec_t& seqs, int k);
+	kmer_bins_t (int k, int bins, const std::string& tmp):
+		part (k, bins), files (bins), fhs (bins) {
+		for (int b = 0; b < bins; ++ b) {
+			files[b] = tmp + "/sfrq_bin" + std::to_string (b) + ".tmp";
+			fhs[b].open (files[b].c_str(), std::ios::binary);
+			if (! fhs[b].good()) abording ("SFrqEst: cannot write " + files[b]);
+		}
+	}
+};
+
+/* k-mer extraction specialised for the run time k, see xny/kmer_kernel.hpp */
+typedef xny::bitkmer_kernel<uint64_t, xny::KMER_MIN,
+		std::back_insert_iterator<u64vec_t> > kmer_kernel_t;
+typedef kmer_kernel_t::fn_t kmer_fn_t;
+
+void estSeqFrq (const strvec_t& ipfqlist, const strvec_t& isfqlist,
+		const fe_t& fe, int batch, int mem, bool silent);
+void output_seqfrq (const ivec_t& frq, const u64vec_t& nreads,
+		const strvec_t& ipfq, const strvec_t& isfq, const fe_t& fe,
+		bool silent);
+void print_frq_histogram (const ivec_t& frq, int threshold);
+void write_kmer_db (const std::string& db, const kcnt_t& kcnt, int k);
 
+/* [counter_t]: kcnt_t, ksketch_t or kmer_bins_t (xny::kmer_db to query) */
+template <typename counter_t>
+uint64_t obtain_kfrq (counter_t& kcnt, kmer_fn_t get_kmers, int batch,
+		const strvec_t& files, bool silent);
+uint64_t kmer_cnt_in_seqs (kcnt_t& kcnt, const strvec_t& seqs,
+		kmer_fn_t get_kmers);
+uint64_t kmer_cnt_in_seqs (ksketch_t& kcnt, const strvec_t& seqs,
+		kmer_fn_t get_kmers);
+uint64_t kmer_cnt_in_seqs (kmer_bins_t& kcnt, const strvec_t& seqs,
+		kmer_fn_t get_kmers);
+uint64_t count_kmer_bins (kmer_bins_t& bins, kmer_fn_t get_kmers, int k,
+		const std::string& db, bool silent);
 
-void obtain_seqfrq (ivec_t& frq, const umap_t& kcnt,	int k,
-		int batch, const strvec_t& files, bool silent) ;
-void seq_freq (ivec_t& frq, const umap_t& kcnt, int k, const strvec_t& seqs);
+template <typename counter_t>
+void obtain_seqfrq (ivec_t& frq, u64vec_t& nreads, const counter_t& kcnt,
+		kmer_fn_t get_kmers, int batch, const strvec_t& files, bool silent);
+template <typename counter_t>
+void seq_freq (ivec_t& frq, const counter_t& kcnt, kmer_fn_t get_kmers,
+		const strvec_t& seqs);
 
 #endif /* SEQFRQEST_H_ */
@@ -29,9 +29,14 @@ void trimming (const strvec_t& ipfq, const strvec_t& isfq,
 
 	// ---------------  read input vector --------------------------
 	std::cout << "\tRead in vectors ...";
-	strvec_t vectors;
+	strvec_t vectors, rvc_vectors;
 	kindex_t kindex; //[kmerID -> list (vecID, vecPos, dir)]
-	process_vector_file (vectors, kindex, trm.vecfa, std::min (trm.min_match, 16));
+	process_vector_file (vectors, rvc_vectors, kindex, trm.vecfa,
+			std::min (trm.min_match, 32));
+	primer_matchers_t matchers;
+	if (trm.engine == "myers") {
+		get_primer_matchers (matchers, vectors, rvc_vectors);
+	}
 
 	if (vectors.size() == 0 || kindex.empty()) {
 		std::cout << "\t\tno vector trimming applied\n\n";
@@ -64,8 +69,8 @@ void trimming (const strvec_t& ipfq, const strvec_t& isfq,
 			xny::openfile<std::ofstream> (ofhs, trm.os[i]);
 		}
 
-		trim_pfq (ipfq[fID], ipfq[fID+1], vectors, kindex, ofhfq,
-				ofhfq2, ofhs, trm, lc, batch);
+		trim_pfq (ipfq[fID], ipfq[fID+1], vectors, rvc_vectors, kindex,
+				matchers, ofhfq, ofhfq2, ofhs, trm, lc, batch);
 
 		if (trm.op.size() > 2) {
 			xny::closefile(ofhfq);
@@ -89,12 +94,13 @@ void trimming (const strvec_t& ipfq, const strvec_t& isfq,
 
 /**	Function process_vector_file ()
  *
- * Given an input fasta file [vecfa], record all vectors in [vectors] and
+ * Given an input fasta file [vecfa], record all vectors in [vectors],
+ * their reverse complements in [rvc_vectors] and
  * process each vector kmer then store information in
  * [kindex]: [kmerID -> list (vecID, vecPos, dir)]
  */
-void process_vector_file (strvec_t& vectors, kindex_t& kindex,
-		const std::string& vecfa, int k) {
+void process_vector_file (strvec_t& vectors, strvec_t& rvc_vectors,
+		kindex_t& kindex, const std::string& vecfa, int k) {
 
 	/* ------------ read input vectors ----------- */
 	std::ifstream fh;
@@ -112,29 +118,46 @@ void process_vector_file (strvec_t& vectors, kindex_t& kindex,
 		// make sure vector doesn't contain 'n' or 'N'
 		if (std::isupper(v.at(0))) std::replace (v.begin(), v.end(), 'N', 'A');
 		else std::replace (v.begin(), v.end(), 'n', 'a');
+		rvc_vectors.push_back (xny::get_rvc_str (v));
 
 		// generate (k)-spectrum for fwd & rvc strands of vector[i]
-		uvec_t kIDs;
-		xny::get_bitkmer<std::back_insert_iterator<uvec_t>, uint32_t>
-			(v, std::back_inserter(kIDs), k, 2);
-
-		for (unsigned int j = 0; j < kIDs.size(); ++ j) {
-			kindex_t::iterator it  = kindex.find(kIDs[j]);
-			if (it != kindex.end()) {
-				if (j % 2 == 0) { // forward strand
-					it->second.push_back(kloc_t(vectorID, j/2, true));
-				} else it->second.push_back(kloc_t(vectorID, j/2, false));
-			} else {
-				if (j % 2 == 0) kindex[kIDs[j]] = { kloc_t(vectorID, j/2, true) };
-				else kindex[kIDs[j]] = { kloc_t (vectorID, j/2, false) };
-			}
+		u64vec_t fIDs, rIDs;
+		cvec_t valid;
+		xny::get_bitkmer_by_pos<uint64_t> (v.data(), v.length(), k,
+				fIDs, &rIDs, valid);
+
+		for (unsigned int j = 0; j < fIDs.size(); ++ j) {
+			if (! valid[j]) continue;
+			kindex.insert (fIDs[j], kloc_t(vectorID, j, true));
+			kindex.insert (rIDs[j], kloc_t(vectorID, j, false));
 		} // for (unsigned int j
 
 		vectorID ++;
 	} // for (auto & v: vectors )
 
+	kindex.build ();
+
 }// process_vector_file
 
+/**	Function get_primer_matchers ()
+ *
+ * For every vector and its reverse complement, build a matcher of its
+ * first 64 bases, which finds the vector inside a read or its prefix at
+ * the end of a read, and a matcher of its last 64 bases reading the read
+ * backwards, which finds a vector suffix at the beginning of a read.
+ */
+void get_primer_matchers (primer_matchers_t& matchers,
+		const strvec_t& vectors, const strvec_t& rvc_vectors) {
+	for (unsigned int i = 0; i < vectors.size(); ++ i) {
+		for (const std::string* v: {&vectors[i], &rvc_vectors[i]}) {
+			int len = v->length(), m = std::min (len, 64);
+			matchers.push_back (xny::myers_matcher (v->data(), m, false));
+			std::string suf (v->rbegin(), v->rbegin() + m); // reversed
+			matchers.push_back (xny::myers_matcher (suf.data(), m, true));
+		}
+	}
+} // get_primer_matchers
+
 
 /* @brief Function trim_sfq ()
  *
@@ -157,10 +180,10 @@ void trim_sfq (std::ofstream& ofhsfq, const std::string& ifq,
  		add_fq_reads (reads, batch, iter_fq, iter_end);
 
  		int read_cnt = reads.size();
-		#pragma omp parallel for
+		#pragma omp parallel for reduction (+: num_trimmed)
  		for (int i = 0; i < read_cnt; ++ i) {
  			if (trim_lc_lq (std::get<1>(reads[i]), std::get<2>(reads[i]),
- 					trm.min_qual, trm.min_rlen, lc)) {
+ 					trm, lc)) {
  				++ num_trimmed;
  			}
  		}
@@ -192,9 +215,10 @@ void trim_sfq (std::ofstream& ofhsfq, const std::string& ifq,
  * -- low complexity criterion
  */
 void trim_pfq (const std::string& ifq, const std::string& ifq2,
-	const strvec_t& vectors, const kindex_t& kindex, std::ofstream& ofhfq,
-	std::ofstream& ofhfq2, std::ofstream& ofhs, const trm_t& trm,
-	 xny::low_complexity& lc, int batch){
+	const strvec_t& vectors, const strvec_t& rvc_vectors,
+	const kindex_t& kindex, const primer_matchers_t& matchers,
+	std::ofstream& ofhfq, std::ofstream& ofhfq2, std::ofstream& ofhs,
+	const trm_t& trm, xny::low_complexity& lc, int batch){
 
 	std::ifstream ifhfq, ifhfq2;
 	xny::openfile<std::ifstream>(ifhfq, ifq);
@@ -210,7 +234,8 @@ void trim_pfq (const std::string& ifq, const std::string& ifq2,
  		add_fq_reads (pairs, batch/2, iter_fq, iter_end);
 		add_fq_reads (pairs, batch/2, iter_fq2, iter_end);
 
-		num_trimmed += apply_trimming (pairs, vectors, kindex, lc, trm);
+		num_trimmed += apply_trimming (pairs, vectors, rvc_vectors, kindex,
+				matchers, lc, trm);
 
 		// output to file
 		int fragnum = pairs.size()/2;
@@ -256,57 +281,80 @@ void trim_pfq (const std::string& ifq, const std::string& ifq2,
 /** Function apply_trimming ()
  *
  * Apply trimming to each read in [seq] return number of trimmed reads,
- * no paired information is used
+ * no paired information is used. A read is trimmed as a window
+ * [rb, re) over its sequence and quality strings, which are cut to the
+ * window once all trimming is done.
  */
 int apply_trimming (std::vector<fqtuple_t>& seq, const strvec_t& vectors,
-		const kindex_t& kindex, xny::low_complexity& lc, const trm_t& trm) {
+		const strvec_t& rvc_vectors, const kindex_t& kindex,
+		const primer_matchers_t& matchers, xny::low_complexity& lc,
+		const trm_t& trm) {
 
 	int sz = seq.size();
-	int k = std::min (trm.min_match, 16);
-
-	bvec_t trimmed (sz, false); // record which reads are trimmed
-	#pragma omp parallel for
+	int k = std::min (trm.min_match, 32);
+	typedef xny::bitkmer_pos_kernel<uint64_t> kpos_kernel_t;
+	kpos_kernel_t::fn_t get_kmers = xny::select_kmer_kernel<kpos_kernel_t> (k);
+
+	cvec_t trimmed (sz, false); // record which reads are trimmed
+	u64vec_t rkmers;
+	cvec_t valid;
+	#pragma omp parallel for private (rkmers, valid)
 	for (int i = 0; i < sz; ++ i) {
-		std::string rseq = std::get<1>(seq[i]);
-		std::string qual = std::get<2>(seq[i]);
+		std::string& rseq = std::get<1>(seq[i]);
+		std::string& qual = std::get<2>(seq[i]);
 		// make sure vector doesn't contain 'n' or 'N'
 		if (std::isupper(rseq.at(0))) {
 			std::replace (rseq.begin(), rseq.end(), 'N', 'A');
 		} else std::replace (rseq.begin(), rseq.end(), 'n', 'a');
 
+		int rb = 0, re = rseq.length();
+
 		// Primer Trimming: checking each read against all primers
-		while (true) {
-			bool trim_applied = false;
+		if (trm.engine == "myers") {
+			while (trim_primer_myers (rseq, rb, re, matchers, trm)) {
+				trimmed[i] = true;
+			}
+		} else {
+			// read kmers are computed once: a trim only shrinks the window
+			// [rb, re), so the kmers inside it are unchanged
+			if (re >= k) {
+				rkmers.resize (re - k + 1);
+				valid.resize (re - k + 1);
+				get_kmers (rseq.data(), re, &rkmers[0], NULL, &valid[0]);
+			}
 
-			uvec_t rkmers;
-			xny::get_bitkmer<std::back_insert_iterator<uvec_t>, uint32_t>
-				(rseq, std::back_inserter(rkmers), k, 3);
+			while (true) {
+				bool trim_applied = false;
 
-			for (unsigned int rPos = 0; rPos < rkmers.size(); ++ rPos) {
+				for (int pos = rb; pos + k <= re; ++ pos) {
+					if (! valid[pos]) continue;
 
-				kindex_t::const_iterator it  = kindex.find(rkmers[rPos]);
+					kindex_t::range_t it  = kindex.find(rkmers[pos]);
 
-				// check if we can do trimming using current kmer: kmers[j]
-				if (it != kindex.end()) {
-					if (trim_primer (rseq, qual, it->second,
-							vectors, rPos, trm)) {
-						trimmed[i] = true;
-						trim_applied = true;
-						break;
+					// check if we can do trimming using current kmer
+					if (it.first != it.second) {
+						if (trim_primer (rseq, rb, re, it, vectors, rvc_vectors,
+								pos - rb, trm)) {
+							trimmed[i] = true;
+							trim_applied = true;
+							break;
+						}
 					}
-				}
-			} // for rPos
+				} // for pos
 
-			// break when no more trimming can be applied to the read
-			if (!trim_applied) break;
+				// break when no more trimming can be applied to the read
+				if (!trim_applied) break;
+			}
 		}
 		// Low quality score and low complexity trimming
-		if (trim_lc_lq (rseq, qual, trm.min_qual, trm.min_rlen, lc)) {
+		if (trim_lc_lq (rseq, qual, rb, re, trm, lc)) {
 			trimmed[i] = true;
 		}
 
-		std::get<1>(seq[i]) = rseq;
-		std::get<2>(seq[i]) = qual;
+		rseq.erase (re);
+		rseq.erase (0, rb);
+		qual.erase (re);
+		qual.erase (0, rb);
 	} // for i
 
 	// counting the trimmed reads
@@ -318,39 +366,42 @@ int apply_trimming (std::vector<fqtuple_t>& seq, const strvec_t& vectors,
 
 /** Function trim_primer ()
  *
- * Apply primer trimming to a read sequence [rSeq] and quality string [qual]
+ * Apply primer trimming to the window [rb, re) of a read sequence [rSeq]
  * For every kmer shared between [rSeq] and an input vector sequence
  * return once the first trimming event happens when
  * the minimum match length is identified; trim is either applied to prefix,
  * suffix, or the complete read by choosing whichever the remaining
- * fragment is longer post-trimming.
+ * fragment is longer post-trimming. [rPos] is relative to [rb]; the
+ * window is updated in place.
  */
-bool trim_primer (std::string& rSeq, std::string& qual,
-		const std::vector<kloc_t>& kloclist,
-		const strvec_t& vectors,	int rPos, const trm_t& trm) {
+bool trim_primer (const std::string& rSeq, int& rb, int& re,
+		const kindex_t::range_t& kloclist, const strvec_t& vectors,
+		const strvec_t& rvc_vectors, int rPos, const trm_t& trm) {
 
-	int k = std::min (16, trm.min_match);
+	int k = std::min (32, trm.min_match);
 
 	int rBegin = rPos, rEnd = rPos + k - 1;
- 	int rLen = rSeq.length();
+ 	int rLen = re - rb;
+ 	const char* r = rSeq.data() + rb;
 
- 	for (auto& kloc: kloclist) { // for each matched kmer locus
+ 	for (const kloc_t* it = kloclist.first; it != kloclist.second; ++ it) {
+		const kloc_t& kloc = *it; // for each matched kmer locus
 
-		std::string myVec = vectors[std::get<0> (kloc)];// vector sequence
+		int vID = std::get<0> (kloc);
+		int vLen = vectors[vID].length();
 		int vBegin = std::get<1> (kloc), vEnd = vBegin + k - 1;
 		bool vDir = std::get<2> (kloc);	// fwd or rv direction
 
-		std::string rPrf = rSeq.substr(0, rBegin),
-				    rSuf = rSeq.substr(rEnd+1, rLen - rEnd),
-					vPrf = myVec.substr(0, vBegin),
-					vSuf = myVec.substr(vEnd+1, myVec.length() - vEnd);
-
 		if (vDir) { // fwd
-			rEnd += xny::common_pref_len (rSuf, vSuf);
-			rBegin -= xny::common_suf_len (rPrf, vPrf);
-		} else { // rv
-			rEnd += xny::common_pref_len (rSuf, xny::get_rvc_str (vPrf));
-			rBegin -= xny::common_suf_len (rPrf, xny::get_rvc_str(vSuf));
+			const char* v = vectors[vID].data();
+			rEnd += xny::common_pref_len (r + rEnd + 1, rLen - rEnd - 1,
+					v + vEnd + 1, vLen - vEnd - 1);
+			rBegin -= xny::common_suf_len (r, rBegin, v, vBegin);
+		} else { // rv: compare against the reverse complementary vector
+			const char* v = rvc_vectors[vID].data();
+			rEnd += xny::common_pref_len (r + rEnd + 1, rLen - rEnd - 1,
+					v + vLen - vBegin, vBegin);
+			rBegin -= xny::common_suf_len (r, rBegin, v, vLen - vEnd - 1);
 		}
 
 		if (rEnd - rBegin + 1 >= trm.min_match) { // apply trimming
@@ -358,15 +409,12 @@ bool trim_primer (std::string& rSeq, std::string& qual,
 				remain_prefix_len = rBegin + 1;
 			if (remain_suffix_len >= remain_prefix_len &&
 				remain_suffix_len >= trm.min_rlen) { //trim prefix
-				rSeq = rSeq.substr(rEnd + 1, remain_suffix_len);
-				qual = qual.substr(rEnd + 1, remain_suffix_len);
+				rb += rEnd + 1;
 			} else if (remain_prefix_len >= remain_suffix_len &&
 					remain_prefix_len >= trm.min_rlen) { // trim suffix
-				rSeq = rSeq.substr(0, remain_prefix_len);
-				qual = qual.substr(0, remain_prefix_len);
+				re = rb + remain_prefix_len;
 			} else {
-				rSeq = ""; // rm whole read
-				qual = "";
+				re = rb; // rm whole read
 			}
 
 			return true;
@@ -376,36 +424,112 @@ bool trim_primer (std::string& rSeq, std::string& qual,
 	return false;
 } // trim_primer
 
-/* @brief	Trim read and quality string by min quality score and
- *	low complexity criteria
+/** Function trim_primer_myers ()
+ *
+ * Apply primer trimming to the window [rb, re) of a read sequence [rSeq]
+ * using bit-parallel matchers, allowing up to trm.max_err mismatches and
+ * indels. The first primer found (a full occurrence of at least
+ * trm.min_match bases, or a partial primer of at least trm.min_match
+ * bases at either read end) is trimmed the same way as in trim_primer ().
+ * Match boundaries of full occurrences are approximate when the match
+ * contains indels.
  */
-bool trim_lc_lq (std::string& rSeq, std::string& qual, int min_qual,
-		int min_len, xny::low_complexity& lc) {
+bool trim_primer_myers (const std::string& rSeq, int& rb, int& re,
+		const primer_matchers_t& matchers, const trm_t& trm) {
+
+	const char* r = rSeq.data() + rb;
+	int rLen = re - rb;
+	if (rLen <= 0) return false;
+
+	for (auto& mt: matchers) {
+		int end, ovl, mBegin = -1, mEnd = -1;
+		mt.scan (r, rLen, trm.max_err, trm.min_match, end, ovl);
+		if (mt.reverse ()) { // primer suffix at the read start
+			if (ovl) { mBegin = 0; mEnd = std::min (ovl, rLen) - 1; }
+		} else if (end != -1 && mt.length() >= trm.min_match) {
+			mBegin = std::max (end - mt.length() + 1, 0);
+			mEnd = end;
+		} else if (ovl) { // primer prefix at the read end
+			mBegin = std::max (rLen - ovl, 0);
+			mEnd = rLen - 1;
+		}
+		if (mBegin == -1) continue;
+
+		int remain_suffix_len = rLen - mEnd - 1,
+			remain_prefix_len = mBegin;
+		if (remain_suffix_len >= remain_prefix_len &&
+			remain_suffix_len >= trm.min_rlen) { //trim prefix
+			rb += mEnd + 1;
+		} else if (remain_prefix_len >= remain_suffix_len &&
+				remain_prefix_len >= trm.min_rlen) { // trim suffix
+			re = rb + remain_prefix_len;
+		} else {
+			re = rb; // rm whole read
+		}
+		return true;
+	}
+	return false;
+} // trim_primer_myers
+
+/* @brief	Trim the window [rb, re) of read and quality string by min
+ *	quality score, sliding window mean quality (trm.win > 0) and low
+ *	complexity criteria, the window is updated in place and is empty if
+ *	the whole read is removed
+ */
+bool trim_lc_lq (const std::string& rSeq, const std::string& qual,
+		int& rb, int& re, const trm_t& trm, xny::low_complexity& lc) {
 	/*	Trim max prefix and suffix where quality score of each base <= min_qual
 	 */
-	int rlen = qual.length();
-	int first_hq_idx = 0, last_hq_idx = rlen - 1;
-	for (auto& c : qual) { // prefix
-		if ((int) c > min_qual) break;
-		++ first_hq_idx;
-	}
-	bool last_pos_found = false;
-	for (; last_hq_idx >= min_len + first_hq_idx - 1; -- last_hq_idx) {
-		if ((int) qual.at(last_hq_idx) - 33 > min_qual) {
-			last_pos_found = true;
-			break;
-		}
+	int rlen = re - rb;
+	const char* q = qual.data() + rb;
+	int first_hq_idx = xny::first_above (q, rlen, trm.min_qual + 33);
+	int last_hq_idx = first_hq_idx + xny::last_above (q + first_hq_idx,
+			rlen - first_hq_idx, trm.min_qual + 33);
+	if (trm.win > 0) {
+		last_hq_idx = first_hq_idx - 1 + quality_window_end (q + first_hq_idx,
+			last_hq_idx - first_hq_idx + 1, trm.win, trm.win_q);
 	}
-	if (last_pos_found) {
-		rSeq = rSeq.substr(first_hq_idx, last_hq_idx - first_hq_idx + 1);
-		if (! lc (rSeq)) {
-			qual = qual.substr(first_hq_idx, last_hq_idx - first_hq_idx + 1);
-			if (rSeq.length() != rlen) return true;
+	int len = last_hq_idx - first_hq_idx + 1;
+	if (len > 0 && len >= trm.min_rlen) {
+		if (! lc (rSeq.data() + rb + first_hq_idx, len)) {
+			rb += first_hq_idx;
+			re = rb + len;
+			if (len != rlen) return true;
 			else return false;
 		}
 	}
-	rSeq.clear();
-	qual.clear();
+	re = rb;
 	return true;
 } // trim_lc_lq
 
+/* @brief	Trim read and quality string by min quality score and
+ *	low complexity criteria
+ */
+bool trim_lc_lq (std::string& rSeq, std::string& qual, const trm_t& trm,
+		xny::low_complexity& lc) {
+	int rb = 0, re = qual.length();
+	bool trimmed = trim_lc_lq (rSeq, qual, rb, re, trm, lc);
+	rSeq.erase (re);
+	rSeq.erase (0, rb);
+	qual.erase (re);
+	qual.erase (0, rb);
+	return trimmed;
+} // trim_lc_lq
+
+/* @brief	Length of the prefix of quality string [q] of length [len]
+ *	before the first window of [w] bases whose mean phred score is below
+ *	[min_q]; windows are evaluated with a running sum. [len] is returned
+ *	if no window fails or the string is shorter than [w].
+ */
+int quality_window_end (const char* q, int len, int w, int min_q) {
+	if (len < w) return len;
+	int sum = 0, min_sum = w * (min_q + 33);
+	for (int i = 0; i < w; ++ i) sum += q[i];
+	for (int i = 0; ; ++ i) {
+		if (sum < min_sum) return i;
+		if (i + w >= len) break;
+		sum += q[i + w] - q[i];
+	}
+	return len;
+} // quality_window_end
+
@@ -23,35 +23,53 @@
 #include "Parameter.h"
 #include "xny/seq_cmp.hpp"
 #include "xny/file_manip.hpp"
+#include "xny/kmer_index.hpp"
+#include "xny/myers.hpp"
 #include "jaz/fastx_iterator.hpp"
 #include "ReadBioFile.h"
 
 
 // kmer location on string s (s_ID, s_startpos, is_fwdstrd)
 typedef std::tuple<int, int, bool> kloc_t;
-// binary_kmer -> list [ kloc_t ]
-typedef std::map<uint32_t, std::vector<kloc_t> > kindex_t;
+// binary_kmer (k <= 32) -> list [ kloc_t ]
+typedef xny::kmer_index<kloc_t> kindex_t;
+// bit-parallel matchers of primer ends, -trm_engine myers
+typedef std::vector<xny::myers_matcher> primer_matchers_t;
 
 void trimming (const strvec_t& ipfq, const strvec_t& isfq,
 	const trm_t& trm, xny::low_complexity& lc, int batch, bool silent);
 
-void process_vector_file (strvec_t& vectors, kindex_t& kindex,
-		const std::string& vecfa, int k);
+void process_vector_file (strvec_t& vectors, strvec_t& rvc_vectors,
+		kindex_t& kindex, const std::string& vecfa, int k);
+
+void get_primer_matchers (primer_matchers_t& matchers,
+		const strvec_t& vectors, const strvec_t& rvc_vectors);
 
 void trim_pfq (const std::string& ifq, const std::string& ifq2,
-	const strvec_t& vectors, const kindex_t& kindex, std::ofstream& ofhfq,
-	std::ofstream& ofhfq2, std::ofstream& ofhfa, const trm_t& trm,
-	xny::low_complexity& lc, int batch);
+	const strvec_t& vectors, const strvec_t& rvc_vectors,
+	const kindex_t& kindex, const primer_matchers_t& matchers,
+	std::ofstream& ofhfq, std::ofstream& ofhfq2, std::ofstream& ofhfa,
+	const trm_t& trm, xny::low_complexity& lc, int batch);
 
 int apply_trimming (std::vector<fqtuple_t>& seq, const strvec_t& vectors,
-		const kindex_t& kindex, xny::low_complexity& lc, const trm_t& trm);
+		const strvec_t& rvc_vectors, const kindex_t& kindex,
+		const primer_matchers_t& matchers, xny::low_complexity& lc,
+		const trm_t& trm);
+
+bool trim_primer (const std::string& rSeq, int& rb, int& re,
+		const kindex_t::range_t& kloclist, const strvec_t& vectors,
+		const strvec_t& rvc_vectors, int rPos, const trm_t& trm);
+
+bool trim_primer_myers (const std::string& rSeq, int& rb, int& re,
+		const primer_matchers_t& matchers, const trm_t& trm);
+
+bool trim_lc_lq (const std::string& rSeq, const std::string& qual,
+		int& rb, int& re, const trm_t& trm, xny::low_complexity& lc);
 
-bool trim_primer (std::string& rSeq, std::string& qual,
-		const std::vector<kloc_t>& kloclist,
-		const strvec_t& vectors,	int rPos, const trm_t& trm);
+bool trim_lc_lq (std::string& rSeq, std::string& qual, const trm_t& trm,
+		xny::low_complexity& lc);
 
-bool trim_lc_lq (std::string& rSeq, std::string& qual, int min_qual,
-		int min_len, xny::low_complexity& lc);
+int quality_window_end (const char* q, int len, int w, int min_q);
 
 void trim_sfq (std::ofstream& ofhsfq, const std::string& ifq,
 		const trm_t& trm, xny::low_complexity& lc, int batch);
@@ -121,6 +121,16 @@ int main (int argc, char** argv){
 			 */
 		case 0: // duprm & low complexity frag removal
 		{
+			if (myPara.drm.ibam.size()) { // BAM in, BAM out
+				if(!myPara.silent) std::cout << "Duplicate removal (BAM)...\n";
+				duplicate_removal_bam (myPara.drm, myPara.w, myPara.w2, lc,
+					myPara.batch, myPara.silent);
+				if(!myPara.silent) {
+					std::cout << "\n\toutput: " << myPara.drm.obam << "\n\n";
+					print_time("duplicate removal complete !\t", timing);
+				}
+				break;
+			}
 			if(!myPara.silent) {
 				std::cout << "Duplicate removal...\n";
 				std::cout << "\tinput: ";
@@ -129,7 +139,7 @@ int main (int argc, char** argv){
 			}
 
 			duplicate_removal (myPara.ipfq, myPara.drm, myPara.w,
-				myPara.w2, lc, myPara.batch, myPara.silent);
+				myPara.w2, lc, myPara.batch, myPara.mem, myPara.silent);
 
 			// update the input paired fastq for next stage !
 			myPara.ipfq = myPara.drm.op;
@@ -197,7 +207,7 @@ int main (int argc, char** argv){
 			 * Output:
 			 * -- a fasta file recording merged pairs
 			 * -- a pair of fastq files recording unmerged pairs
-			 * Note: the second pair is reverse complemented wrt the input
+			 * Note: unmerged pairs are written as in the input
 			 */
 			if(!myPara.silent) {
 				std::cout << "Merge paired-read ...\n";
@@ -207,7 +217,7 @@ int main (int argc, char** argv){
 			}
 
 			merge_paired_read (myPara.ipfq, myPara.prm.op,
-							   myPara.prm.os, myPara.batch);
+							   myPara.prm.os, myPara.prm.trim_adapter, myPara.batch);
 
 			// update the input paired fastq and fasta for the next stage
 			myPara.ipfq = strvec_t { myPara.prm.op.first, myPara.prm.op.second };
@@ -237,9 +247,38 @@ int main (int argc, char** argv){
 				std::cout << "\n\n";
 			}
 
-			estSeqFrq (myPara.ipfq, myPara.isfq, myPara.fe_k, myPara.batch, myPara.silent);
+			estSeqFrq (myPara.ipfq, myPara.isfq, myPara.fe, myPara.batch,
+					myPara.mem, myPara.silent);
+
+			// update the input fastq files for the next stage
+			if (myPara.fe.op.size()) {
+				myPara.ipfq = myPara.fe.op;
+				myPara.isfq = strvec_t { myPara.fe.os };
+
+				// update intermediate_files that may be removed
+				intermediate_files.insert(myPara.fe.op.begin(), myPara.fe.op.end());
+				intermediate_files.insert(myPara.fe.os);
+
+				if (!myPara.silent) {
+					std::cout << "\n\toutput:";
+					for (auto& x: myPara.fe.op) std::cout << "\n\t\t" << x;
+					std::cout << "\n\t\t" << myPara.fe.os << "\n\n";
+				}
+			}
 			if(!myPara.silent) print_time("seq frq estimate complete !\t", timing);
 			break;
+		case 4: // duplicate rate estimate from a subsample of pairs
+			if (!myPara.silent) {
+				std::cout << "Duplicate rate estimate ...\n";
+				std::cout << "\tinput: ";
+				for (auto& x : myPara.ipfq) std::cout << "\n\t\t" << x;
+				std::cout << "\n\n";
+			}
+
+			estimate_dupl_rate (myPara.ipfq, myPara.drm, lc, myPara.est_n,
+					myPara.batch, myPara.silent);
+			if(!myPara.silent) print_time("duplicate rate estimate complete !\t", timing);
+			break;
 		default:
 			break;
 
@@ -247,6 +286,13 @@ int main (int argc, char** argv){
 	} // for (auto& x: myPara.tasks) {
 
 	//---------- consolidate final output files -------------------
+	if (! myPara.writes_fq ()) { // no reads written, e.g. BAM input, DupEst
+		if (!myPara.silent) {
+			print_time("Whole program takes \t", start_time);
+			std::cout << "DONE!\n";
+		}
+		return (EXIT_SUCCESS);
+	}
 
 	if (!myPara.silent) std::cout << "\nconsolidate output files...\n";
 
@@ -268,7 +314,8 @@ int main (int argc, char** argv){
 	}
 
     // consolidate
-	if (pfq1.size() == 1 && !myPara.noclean) {
+	if (myPara.opfq.size() != 2) { // nothing to consolidate, e.g. BAM input
+	} else if (pfq1.size() == 1 && !myPara.noclean) {
 		std::cout << "\trenaming " << pfq1[0] << " to " << myPara.opfq[0] << "\n";
 		std::rename(pfq1.front().c_str(), myPara.opfq.front().c_str());
 		std::cout << "\trenaming " << pfq2[0] << " to " << myPara.opfq[1] << "\n";
@@ -282,7 +329,8 @@ int main (int argc, char** argv){
 		xny::append2file(myPara.opfq.back(), pfq2);
 	}
 
-	if (sfq.size() == 1 && !myPara.noclean) { // change name
+	if (myPara.osfq.empty()) {
+	} else if (sfq.size() == 1 && !myPara.noclean) { // change name
 		std::cout << "\trenaming " << sfq[0] << " to " << myPara.osfq << "\n";
 		std::rename(sfq[0].c_str(), myPara.osfq.c_str());
 		sfq.clear();
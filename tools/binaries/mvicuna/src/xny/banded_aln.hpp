@@ -0,0 +1,370 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : banded_aln.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Banded gapped overlap alignment of read pairs
+//========================================================================
+
+
+#ifndef BANDED_ALN_HPP_
+#define BANDED_ALN_HPP_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+#include "kmer_kernel.hpp"
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xny{
+	/**
+	 * Gapped suffix prefix (overlap) alignment of DNA strings s0 and s1
+	 * restricted to a band of 16 diagonals, for read pairs whose overlap
+	 * has indels (e.g. homopolymer length errors).
+	 *
+	 * The band is centred on the diagonal voted by exact 12-mer seeds
+	 * taken near both ends of both strings. One row of the band (16 int16
+	 * cells) is computed with two SSE2 registers: diagonal and vertical
+	 * moves are lane-wise, horizontal gaps are resolved by a log-step
+	 * prefix max, which is exact for the linear gap cost used. Cost is
+	 * O(overlap length) register operations per pair, buffers are reused
+	 * between calls, so a copy per thread is needed.
+	 *
+	 * An alignment starts on the first row or column and ends on the last
+	 * row or column; it is accepted if it has >= [min_len_] columns, at
+	 * most [max_gaps_] gap columns and identity (gap columns count as
+	 * errors) >= [min_perc_identi_]; N matches anything.
+	 */
+	class banded_overlap_aln {
+	public:
+		banded_overlap_aln (int min_len, int pi, int max_gaps):
+			min_len_ (min_len), min_perc_identi_ (pi), max_gaps_ (max_gaps),
+			begin0_ (-1), end0_ (-1), begin1_ (-1), end1_ (-1) { }
+
+		/** Function: operator()
+		 *  Align s0 of length [l0] and s1 of length [l1] (the reverse
+		 *  complement of [s1] if [rvc1]), return true if an acceptable
+		 *  alignment is found. Coordinates on s1 refer to the reverse
+		 *  complement if [rvc1].
+		 */
+		bool operator() (const char* s0, int l0, const char* s1, int l1,
+				bool rvc1) {
+			encode (s0, l0, s1, l1, rvc1);
+			int diag;
+			if (! vote_diagonal (l0, l1, diag)) return false;
+			if (! align (l0, l1, diag)) return false;
+
+			int mm = 0, gaps = 0, i = begin1_, j = begin0_;
+			for (size_t c = 0; c < ops_.size(); ++ c) {
+				if (ops_[c] == 'M') {
+					uint8_t a = c0_[pad_ + j], b = c1_[i];
+					if (a != b && a != 4 && b != 4) ++ mm;
+					++ i;
+					++ j;
+				} else {
+					++ gaps;
+					if (ops_[c] == 'I') ++ j;
+					else ++ i;
+				}
+			}
+			int cols = ops_.size();
+			return cols >= min_len_ && gaps <= max_gaps_ &&
+					mm + gaps <= cols * (100 - min_perc_identi_) / 100;
+		} // operator()
+
+		/* first and last aligned positions on s0 and s1 */
+		int begin0 () const { return begin0_; }
+		int end0 () const { return end0_; }
+		int begin1 () const { return begin1_; }
+		int end1 () const { return end1_; }
+
+		/* alignment columns from (begin0, begin1): 'M' aligned pair,
+		 * 'I' base of s0 only, 'D' base of s1 only
+		 */
+		const std::string& ops () const { return ops_; }
+
+	private:
+		static const int band_ = 16, half_ = 7; // lane k: j = i + diag + k - half_
+		static const int pad_ = 16;
+		static const int seed_ = 12;
+		static const int match_ = 2, mismatch_ = -3, gap_ = -4;
+		static const int16_t neg_ = -10000;
+
+		int min_len_;
+		int min_perc_identi_;
+		int max_gaps_;
+		int begin0_, end0_, begin1_, end1_;
+		std::string ops_;
+		std::vector<uint8_t> c0_, c1_; // 0-3 ACGT, 4 N, 5 outside s0
+		std::vector<int16_t> h_; // band rows
+
+		void encode (const char* s0, int l0, const char* s1, int l1,
+				bool rvc1) {
+			const int8_t* code = kmer_code_table ();
+			c0_.assign (l0 + 2 * pad_, 5);
+			for (int j = 0; j < l0; ++ j) {
+				int c = code[(unsigned char) s0[j]];
+				c0_[pad_ + j] = (c < 0) ? 4 : c;
+			}
+			c1_.resize (l1);
+			for (int i = 0; i < l1; ++ i) {
+				int c = rvc1 ? code[(unsigned char) s1[l1 - i - 1]] :
+						code[(unsigned char) s1[i]];
+				c1_[i] = (c < 0) ? 4 : (rvc1 ? 3 - c : c);
+			}
+		} // encode
+
+		/* position of the first occurrence of the 12-mer of [c] starting
+		 * at [p] in [t] of length [n], -1 if none
+		 */
+		static int find_seed (const uint8_t* c, int p, const uint8_t* t,
+				int n) {
+			uint32_t key = 0;
+			for (int x = 0; x < seed_; ++ x) {
+				if (c[p + x] > 3) return -1;
+				key = (key << 2) | c[p + x];
+			}
+			const uint32_t mask = (1u << (2 * seed_)) - 1;
+			uint32_t cur = 0;
+			int run = 0;
+			for (int x = 0; x < n; ++ x) {
+				if (t[x] > 3) { run = 0; continue; }
+				cur = ((cur << 2) | t[x]) & mask;
+				if (++ run >= seed_ && cur == key) return x - seed_ + 1;
+			}
+			return -1;
+		} // find_seed
+
+		/* diagonal (s0 pos - s1 pos) supported by most seeds taken two
+		 * seed lengths into both ends of both strings
+		 */
+		bool vote_diagonal (int l0, int l1, int& diag) const {
+			if (l0 < 3 * seed_ || l1 < 3 * seed_) return false;
+			const uint8_t* a = &c0_[pad_], *b = &c1_[0];
+			int diags[8], n = 0;
+			for (int p = 1; p <= 1 + seed_; p += seed_) {
+				int x;
+				if ((x = find_seed (b, p, a, l0)) != -1) diags[n ++] = x - p;
+				if ((x = find_seed (b, l1 - seed_ - p, a, l0)) != -1)
+					diags[n ++] = x - (l1 - seed_ - p);
+				if ((x = find_seed (a, p, b, l1)) != -1) diags[n ++] = p - x;
+				if ((x = find_seed (a, l0 - seed_ - p, b, l1)) != -1)
+					diags[n ++] = l0 - seed_ - p - x;
+			}
+			if (n == 0) return false;
+			// mode within half band, then centre of the supporting seeds
+			int best = -1, best_cnt = 0;
+			for (int x = 0; x < n; ++ x) {
+				int cnt = 0;
+				for (int y = 0; y < n; ++ y) {
+					if (std::abs (diags[y] - diags[x]) <= half_) ++ cnt;
+				}
+				if (cnt > best_cnt) { best_cnt = cnt; best = x; }
+			}
+			int lo = diags[best], hi = diags[best];
+			for (int y = 0; y < n; ++ y) {
+				if (std::abs (diags[y] - diags[best]) <= half_) {
+					lo = std::min (lo, diags[y]);
+					hi = std::max (hi, diags[y]);
+				}
+			}
+			diag = (lo + hi) / 2;
+			return true;
+		} // vote_diagonal
+
+		int16_t sub (int i, int j) const {
+			uint8_t a = c0_[pad_ + j], b = c1_[i];
+			if (a == 4 || b == 4) return 0;
+			return (a == b) ? match_ : mismatch_;
+		} // sub
+
+#if defined (__SSE2__)
+		template <int S>
+		static void shift_up_lanes (__m128i& lo, __m128i& hi,
+				const __m128i& negv) {
+			// lane k <- lane k - S, lanes < S get neg_
+			hi = _mm_or_si128 (_mm_slli_si128 (hi, 2 * S),
+					_mm_srli_si128 (lo, 16 - 2 * S));
+			lo = _mm_or_si128 (_mm_slli_si128 (lo, 2 * S),
+					_mm_srli_si128 (negv, 16 - 2 * S));
+		} // shift_up_lanes
+
+		/* fill band row [h] of s1 position [i] from the previous row
+		 * [prev] (NULL for none); [start] is the lane of s0 position 0,
+		 * all lanes may start on row 0
+		 */
+		void fill_row (int16_t* h, const int16_t* prev, int i, int base,
+				int start) const {
+			const __m128i negv = _mm_set1_epi16 (neg_),
+				gapv = _mm_set1_epi16 (gap_);
+
+			// substitution scores
+			__m128i c = _mm_loadu_si128 ((const __m128i*) &c0_[base]);
+			__m128i q = _mm_set1_epi8 (c1_[i]);
+			__m128i eq = _mm_cmpeq_epi8 (c, q);
+			__m128i is_n = _mm_cmpeq_epi8 (c, _mm_set1_epi8 (4));
+			if (c1_[i] == 4) is_n = _mm_set1_epi8 (-1);
+			__m128i out = _mm_cmpeq_epi8 (c, _mm_set1_epi8 (5));
+			__m128i sb = _mm_or_si128 (_mm_and_si128 (eq, _mm_set1_epi8 (match_)),
+					_mm_andnot_si128 (eq, _mm_set1_epi8 (mismatch_)));
+			sb = _mm_andnot_si128 (is_n, sb);
+			__m128i slo = _mm_srai_epi16 (_mm_unpacklo_epi8 (sb, sb), 8),
+				shi = _mm_srai_epi16 (_mm_unpackhi_epi8 (sb, sb), 8),
+				olo = _mm_srai_epi16 (_mm_unpacklo_epi8 (out, out), 8),
+				ohi = _mm_srai_epi16 (_mm_unpackhi_epi8 (out, out), 8);
+
+			// start cells score from 0
+			__m128i stlo = negv, sthi = negv;
+			if (i == 0) {
+				stlo = sthi = _mm_setzero_si128 ();
+			} else if (start >= 0 && start < band_) {
+				int16_t st[band_];
+				std::fill (st, st + band_, (int16_t) neg_);
+				st[start] = 0;
+				stlo = _mm_loadu_si128 ((const __m128i*) st);
+				sthi = _mm_loadu_si128 ((const __m128i*) (st + 8));
+			}
+
+			__m128i plo = negv, phi = negv;
+			if (prev) {
+				plo = _mm_loadu_si128 ((const __m128i*) prev);
+				phi = _mm_loadu_si128 ((const __m128i*) (prev + 8));
+			}
+			// diagonal move
+			__m128i hlo = _mm_adds_epi16 (_mm_max_epi16 (plo, stlo), slo),
+				hhi = _mm_adds_epi16 (_mm_max_epi16 (phi, sthi), shi);
+			// vertical move: lane k <- lane k + 1 of the previous row
+			__m128i ulo = _mm_or_si128 (_mm_srli_si128 (plo, 2),
+					_mm_slli_si128 (phi, 14)),
+				uhi = _mm_or_si128 (_mm_srli_si128 (phi, 2),
+					_mm_slli_si128 (negv, 14));
+			hlo = _mm_max_epi16 (hlo, _mm_adds_epi16 (ulo, gapv));
+			hhi = _mm_max_epi16 (hhi, _mm_adds_epi16 (uhi, gapv));
+
+			// horizontal moves: prefix max over 1, 2, 4, 8 lanes
+			__m128i xlo = hlo, xhi = hhi;
+			shift_up_lanes<1> (xlo, xhi, negv);
+			hlo = _mm_max_epi16 (hlo, _mm_adds_epi16 (xlo, gapv));
+			hhi = _mm_max_epi16 (hhi, _mm_adds_epi16 (xhi, gapv));
+			xlo = hlo; xhi = hhi;
+			shift_up_lanes<2> (xlo, xhi, negv);
+			__m128i g = _mm_set1_epi16 (2 * gap_);
+			hlo = _mm_max_epi16 (hlo, _mm_adds_epi16 (xlo, g));
+			hhi = _mm_max_epi16 (hhi, _mm_adds_epi16 (xhi, g));
+			xlo = hlo; xhi = hhi;
+			shift_up_lanes<4> (xlo, xhi, negv);
+			g = _mm_set1_epi16 (4 * gap_);
+			hlo = _mm_max_epi16 (hlo, _mm_adds_epi16 (xlo, g));
+			hhi = _mm_max_epi16 (hhi, _mm_adds_epi16 (xhi, g));
+			g = _mm_set1_epi16 (8 * gap_);
+			hhi = _mm_max_epi16 (hhi, _mm_adds_epi16 (hlo, g));
+
+			// cells outside s0
+			hlo = _mm_max_epi16 (_mm_or_si128 (_mm_and_si128 (olo, negv),
+					_mm_andnot_si128 (olo, hlo)), negv);
+			hhi = _mm_max_epi16 (_mm_or_si128 (_mm_and_si128 (ohi, negv),
+					_mm_andnot_si128 (ohi, hhi)), negv);
+			_mm_storeu_si128 ((__m128i*) h, hlo);
+			_mm_storeu_si128 ((__m128i*) (h + 8), hhi);
+		} // fill_row
+#else
+		/* fill band row [h] of s1 position [i] from the previous row
+		 * [prev] (NULL for none); [start] is the lane of s0 position 0,
+		 * all lanes may start on row 0
+		 */
+		void fill_row (int16_t* h, const int16_t* prev, int i, int base,
+				int start) const {
+			for (int k = 0; k < band_; ++ k) {
+				uint8_t a = c0_[base + k], b = c1_[i];
+				int s = (a == 4 || b == 4) ? 0 : (a == b ? match_ : mismatch_);
+				int st = (i == 0 || k == start) ? 0 : neg_;
+				int d = std::max (prev ? (int) prev[k] : neg_, st) + s;
+				int u = ((prev && k + 1 < band_) ? prev[k + 1] : neg_) + gap_;
+				h[k] = std::max (std::max (d, u), (int) neg_);
+			}
+			for (int k = 1; k < band_; ++ k) {
+				h[k] = std::max ((int) h[k], h[k - 1] + gap_);
+			}
+			for (int k = 0; k < band_; ++ k) {
+				if (c0_[base + k] == 5) h[k] = neg_;
+			}
+		} // fill_row
+#endif
+
+		/* banded DP around [diag] and traceback of the best alignment */
+		bool align (int l0, int l1, int diag) {
+			int ib = std::max (0, - diag - band_ + half_ + 1),
+				ie = std::min (l1, l0 - diag + half_);
+			if (ib >= ie) return false;
+			h_.resize ((ie - ib) * band_);
+
+			int best = neg_ / 2, bi = -1, bk = -1;
+			for (int i = ib; i < ie; ++ i) {
+				int16_t* h = &h_[(i - ib) * band_];
+				fill_row (h, (i > ib) ? h - band_ : NULL, i,
+						pad_ + i + diag - half_, half_ - i - diag);
+				if (i == l1 - 1) {
+					for (int k = 0; k < band_; ++ k) {
+						if (h[k] > best) { best = h[k]; bi = i; bk = k; }
+					}
+				} else {
+					int k = l0 - 1 - i - diag + half_;
+					if (k >= 0 && k < band_ && h[k] > best) {
+						best = h[k];
+						bi = i;
+						bk = k;
+					}
+				}
+			}
+			if (bi == -1) return false;
+
+			end1_ = bi;
+			end0_ = bi + diag + bk - half_;
+			ops_.clear();
+			int i = bi, k = bk;
+			while (true) {
+				int j = i + diag + k - half_;
+				const int16_t* h = &h_[(i - ib) * band_];
+				int s = sub (i, j);
+				if (i > ib && (h - band_)[k] > neg_ / 2 &&
+						h[k] == (h - band_)[k] + s) {
+					ops_ += 'M';
+					-- i;
+				} else if ((i == 0 || j == 0) && h[k] == s) {
+					ops_ += 'M';
+					begin0_ = j;
+					begin1_ = i;
+					break;
+				} else if (i > ib && k + 1 < band_ &&
+						(h - band_)[k + 1] > neg_ / 2 &&
+						h[k] == (h - band_)[k + 1] + gap_) {
+					ops_ += 'D';
+					-- i;
+					++ k;
+				} else if (k > 0 && h[k - 1] > neg_ / 2 &&
+						h[k] == h[k - 1] + gap_) {
+					ops_ += 'I';
+					-- k;
+				} else return false;
+			}
+			std::reverse (ops_.begin(), ops_.end());
+			return true;
+		} // align
+	}; // class banded_overlap_aln
+
+} // namespace xny
+
+#endif /* BANDED_ALN_HPP_ */
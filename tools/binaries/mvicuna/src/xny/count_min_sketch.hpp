@@ -0,0 +1,133 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : count_min_sketch.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Count-min sketch of 64 bit keys, with conservative
+//				 update
+//========================================================================
+
+
+#ifndef COUNT_MIN_SKETCH_HPP_
+#define COUNT_MIN_SKETCH_HPP_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include "../jaz/hash.hpp"
+
+namespace xny{
+	/**
+	 * Count-min sketch (Cormode & Muthukrishnan 2005) of 64 bit keys with
+	 * [depth] rows of [width] 32 bit counters. An estimate never
+	 * underestimates the true count; it exceeds it by at most e / width
+	 * of the total count added with probability 1 - e^-depth.
+	 */
+	class count_min_sketch {
+	public:
+		/** constructor count_min_sketch ()
+		 *
+		 * [width] is rounded up to a power of 2
+		 */
+		count_min_sketch (uint64_t width, int depth): depth_ (depth) {
+			uint64_t w = 1;
+			while (w < width) w *= 2;
+			mask_ = w - 1;
+			table_.assign(w * depth_, 0);
+			locks_.assign(num_locks, 0);
+		}
+
+		/** Function: add ()
+		 *  Increase the count of [key] by [cnt]
+		 */
+		void add (uint64_t key, uint32_t cnt = 1) {
+			for (int r = 0; r < depth_; ++ r) {
+				uint32_t& c = table_[r * (mask_ + 1) + index (key, r)];
+				c = (c > std::numeric_limits<uint32_t>::max() - cnt) ?
+						std::numeric_limits<uint32_t>::max() : c + cnt;
+			}
+		} // add
+
+		/** Function: add_conservative ()
+		 *  Conservative update (Estan & Varghese 2002): raise only the
+		 *  counters of [key] that are below estimate + [cnt], which keeps
+		 *  the guarantee of add () with a smaller overestimate. Thread
+		 *  safe: updates of the same key are serialized by a lock stripe,
+		 *  counters shared with other keys are only ever raised.
+		 */
+		void add_conservative (uint64_t key, uint32_t cnt = 1) {
+			char* lock = &locks_[hash (key, depth_) & (num_locks - 1)];
+			while (__sync_lock_test_and_set (lock, 1)) {
+				while (__atomic_load_n (lock, __ATOMIC_RELAXED)) {}
+			}
+			uint32_t est = std::numeric_limits<uint32_t>::max();
+			for (int r = 0; r < depth_; ++ r) {
+				est = std::min (est, __atomic_load_n (&table_[r * (mask_ + 1) +
+						index (key, r)], __ATOMIC_RELAXED));
+			}
+			uint32_t target = (est > std::numeric_limits<uint32_t>::max() - cnt) ?
+					std::numeric_limits<uint32_t>::max() : est + cnt;
+			for (int r = 0; r < depth_; ++ r) {
+				uint32_t* c = &table_[r * (mask_ + 1) + index (key, r)];
+				uint32_t cur = __atomic_load_n (c, __ATOMIC_RELAXED);
+				while (cur < target) {
+					uint32_t prev = __sync_val_compare_and_swap (c, cur, target);
+					if (prev == cur) break;
+					cur = prev;
+				}
+			}
+			__sync_lock_release (lock);
+		} // add_conservative
+
+		/** Function: estimate ()
+		 *  Return the estimated count of [key]
+		 */
+		uint32_t estimate (uint64_t key) const {
+			uint32_t est = std::numeric_limits<uint32_t>::max();
+			for (int r = 0; r < depth_; ++ r) {
+				est = std::min (est, table_[r * (mask_ + 1) + index (key, r)]);
+			}
+			return est;
+		} // estimate
+
+		uint64_t width () const { return mask_ + 1; }
+		int depth () const { return depth_; }
+		uint64_t bytes () const { return table_.size() * sizeof (uint32_t); }
+
+		/* additive error bound per unit of total count, e / width */
+		double epsilon () const { return 2.718281828 / (mask_ + 1); }
+
+		/* probability that an estimate exceeds the error bound, e^-depth */
+		double delta () const { return std::exp (- (double) depth_); }
+
+	private:
+		static const int num_locks = 1 << 12;
+		int depth_;
+		uint64_t mask_;
+		std::vector<uint32_t> table_;
+		std::vector<char> locks_;
+
+		/* hash of the key seeded by the row */
+		static uint64_t hash (uint64_t key, int r) {
+			return jaz::mxs64 ((r + 1) * 0x9e3779b97f4a7c15ULL) (key);
+		}
+
+		uint64_t index (uint64_t key, int r) const {
+			return hash (key, r) & mask_;
+		}
+	}; // class count_min_sketch
+
+} // namespace xny
+
+#endif /* COUNT_MIN_SKETCH_HPP_ */
@@ -0,0 +1,160 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : cuckoo_filter.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Cuckoo filter of fragment signatures for single pass
+//				 (-drm_stream) duplicate removal
+//========================================================================
+
+
+#ifndef CUCKOO_FILTER_HPP_
+#define CUCKOO_FILTER_HPP_
+
+#include <vector>
+#include <cmath>
+#include <stdint.h>
+
+namespace xny{
+	/**
+	 * Fixed size cuckoo filter (Fan et al. 2014) storing fingerprints of
+	 * 64 bit hash values, with 4 slots per bucket and partial-key cuckoo
+	 * hashing. The fingerprint type [fp_t] (uint8_t, uint16_t, uint32_t)
+	 * trades memory for the false positive rate.
+	 */
+	template <typename fp_t>
+	class cuckoo_filter {
+	public:
+		/** constructor cuckoo_filter ()
+		 *
+		 * The number of buckets is the largest power of 2 fitting in
+		 * [bytes]; at least one bucket is allocated
+		 */
+		cuckoo_filter (uint64_t bytes): num_items_(0), has_victim_(false),
+			victim_idx_(0), victim_fp_(0), rnd_(88172645463325252ULL) {
+			uint64_t num_buckets = 1;
+			while (2 * num_buckets * slots * sizeof(fp_t) <= bytes) {
+				num_buckets *= 2;
+			}
+			mask_ = num_buckets - 1;
+			table_.assign(num_buckets * slots, 0);
+		}
+
+		/** Function: contains ()
+		 *  Return true if hash value [h] may have been inserted
+		 */
+		bool contains (uint64_t h) const {
+			fp_t fp = fingerprint (h);
+			uint64_t i1 = h & mask_, i2 = alt_index (i1, fp);
+			if (has_victim_ && victim_fp_ == fp &&
+				(victim_idx_ == i1 || victim_idx_ == i2)) return true;
+			return in_bucket (i1, fp) || in_bucket (i2, fp);
+		} // contains
+
+		/** Function: insert ()
+		 *  Insert hash value [h]; return false if the filter is full
+		 */
+		bool insert (uint64_t h) {
+			if (has_victim_) return false;
+			fp_t fp = fingerprint (h);
+			uint64_t i1 = h & mask_, i2 = alt_index (i1, fp);
+			if (add_to_bucket (i1, fp) || add_to_bucket (i2, fp)) {
+				++ num_items_;
+				return true;
+			}
+			// relocate existing fingerprints
+			uint64_t idx = (next_rand() & 1) ? i1 : i2;
+			for (int kick = 0; kick < max_kicks; ++ kick) {
+				fp_t& slot = table_[idx * slots + next_rand() % slots];
+				std::swap (fp, slot);
+				idx = alt_index (idx, fp);
+				if (add_to_bucket (idx, fp)) {
+					++ num_items_;
+					return true;
+				}
+			}
+			// keep the last evicted fingerprint so that nothing is lost
+			has_victim_ = true;
+			victim_idx_ = idx;
+			victim_fp_ = fp;
+			++ num_items_;
+			return true;
+		} // insert
+
+		uint64_t size () const { return num_items_; }
+
+		uint64_t bytes () const { return table_.size() * sizeof(fp_t); }
+
+		double load_factor () const {
+			return (double) num_items_ / table_.size();
+		}
+
+		/** Function: fp_rate ()
+		 *  Expected false positive rate of a lookup at the current load:
+		 *  each of the 2 candidate buckets holds 4*load fingerprints, each
+		 *  matching with probability 1/(2^f - 1)
+		 */
+		double fp_rate () const {
+			double p = 1.0 / (std::pow(2.0, 8.0 * sizeof(fp_t)) - 1);
+			return 1.0 - std::pow(1.0 - p, 2.0 * slots * load_factor());
+		}
+
+	private:
+		static const int slots = 4;
+		static const int max_kicks = 500;
+
+		uint64_t mask_;
+		uint64_t num_items_;
+		std::vector<fp_t> table_;
+		bool has_victim_;
+		uint64_t victim_idx_;
+		fp_t victim_fp_;
+		uint64_t rnd_;
+
+		/* fingerprint from the upper bits of [h]; 0 marks an empty slot */
+		fp_t fingerprint (uint64_t h) const {
+			fp_t fp = (fp_t) (h >> (64 - 8 * sizeof(fp_t)));
+			return fp ? fp : 1;
+		}
+
+		uint64_t alt_index (uint64_t idx, fp_t fp) const {
+			return (idx ^ ((uint64_t) fp * 0xc6a4a7935bd1e995ULL)) & mask_;
+		}
+
+		bool in_bucket (uint64_t idx, fp_t fp) const {
+			const fp_t* b = &table_[idx * slots];
+			return b[0] == fp || b[1] == fp || b[2] == fp || b[3] == fp;
+		}
+
+		bool add_to_bucket (uint64_t idx, fp_t fp) {
+			fp_t* b = &table_[idx * slots];
+			for (int s = 0; s < slots; ++ s) {
+				if (b[s] == 0) {
+					b[s] = fp;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/* xorshift64; deterministic eviction order */
+		uint64_t next_rand () {
+			rnd_ ^= rnd_ << 13;
+			rnd_ ^= rnd_ >> 7;
+			rnd_ ^= rnd_ << 17;
+			return rnd_;
+		}
+	}; // class cuckoo_filter
+
+} // namespace xny
+
+#endif /* CUCKOO_FILTER_HPP_ */
@@ -0,0 +1,189 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : fragment_kernel.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Single scan encoding of a read pair into seeds, super
+//				 sketch and base composition for DupRm
+//========================================================================
+
+
+#ifndef FRAGMENT_KERNEL_HPP_
+#define FRAGMENT_KERNEL_HPP_
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <stdint.h>
+
+namespace xny{
+	/**
+	 * Per fragment encoding kernel of duplicate removal. A read pair is
+	 * scanned once, base by base, to build the fragment (mate 1 followed
+	 * by mate 2, N replaced by A), its reverse complement, the 2-bit code
+	 * of every base and the base composition (ACGT/other, case folded).
+	 * Seeds and the super sketch are then derived from these buffers
+	 * without temporary strings. Results are identical to the original
+	 * str2ID/get_rvc_bits seeds, sketch_list/super_sketch and
+	 * low_complexity computations.
+	 *
+	 * Buffers are reused across calls: use one instance per thread.
+	 */
+	class fragment_kernel {
+	public:
+		/** constructor fragment_kernel ()
+		 *
+		 * [seed_len]: seed length (<= 31); [k]: sketch k-mer length;
+		 * [w]: number of sketches forming a super sketch
+		 */
+		fragment_kernel (int seed_len, int k, int w): seed_len_(seed_len),
+			k_(k), w_(w) {
+			for (int c = 0; c < 256; ++ c) {
+				code_[c] = -1;
+				comp_[c] = 4;
+				rvc_[c] = 'n';
+			}
+			const char* fwd = "ACGTacgt";
+			const char* rvc = "TGCAtgca";
+			for (int i = 0; i < 8; ++ i) {
+				code_[(unsigned char) fwd[i]] = i % 4;
+				comp_[(unsigned char) fwd[i]] = i % 4;
+				rvc_[(unsigned char) fwd[i]] = rvc[i];
+			}
+		}
+
+		/** Function: operator()
+		 *
+		 * Scan the read pair [r1], [r2]. Afterwards, the composition is
+		 * available via composition() and seeds()/super_sketch() can be
+		 * called.
+		 */
+		void operator() (const std::string& r1, const std::string& r2) {
+			len_ = r1.length() + r2.length();
+			frag_.resize (len_);
+			rvc_frag_.resize (len_);
+			codes_.resize (len_);
+			std::fill (counter_, counter_ + 5, 0);
+			if (len_ == 0) return;
+
+			// N -> A or n -> a according to the case of the first base
+			char n = std::isupper (r1.size() ? r1[0] : r2[0]) ? 'N' : 'n',
+				a = (n == 'N') ? 'A' : 'a';
+			scan (r1, 0, n, a);
+			scan (r2, r1.length(), n, a);
+		} // operator()
+
+		/** Function: composition ()
+		 *
+		 * Counts of A, C, G, T and other bases of the (unmodified) fragment
+		 */
+		const int* composition () const { return counter_; }
+
+		int length () const { return len_; }
+
+		/** Function: seeds ()
+		 *
+		 * Non-overlapping canonical seeds of length [seed_len], followed by
+		 * the possible last shorter seed; -1 marks a seed containing a
+		 * non-ACGT base
+		 */
+		void seeds (std::vector<int64_t>& out) const {
+			int num_seed = len_/seed_len_;
+			out.clear();
+			for (int i = 0; i < num_seed; ++ i) {
+				out.push_back (seed (i * seed_len_, seed_len_));
+			}
+			int last_seed_len = len_ - num_seed * seed_len_;
+			if (last_seed_len != 0) {
+				out.push_back (seed (len_ - last_seed_len, last_seed_len));
+			}
+		} // seeds
+
+		/** Function: super_sketch ()
+		 *
+		 * The super sketch value of the fragment: [hfunc] hashes of the
+		 * alphabetically larger strand of every k-mer are sorted, and the
+		 * minimum hash over windows of [w] consecutive values is returned.
+		 * Return false (and [ss] is untouched) if there are less than
+		 * [w] k-mers.
+		 */
+		template <typename T>
+		bool super_sketch (uint64_t& ss, const T& hfunc) {
+			int num = len_ - k_ + 1;
+			if (num - w_ + 1 <= 0) return false;
+
+			sketches_.resize (num);
+			const char* fwd = frag_.data();
+			const char* rvc = rvc_frag_.data();
+			for (int i = 0; i < num; ++ i) {
+				const char* s = fwd + i,
+						* s_rvc = rvc + len_ - i - k_;
+				if (memcmp (s, s_rvc, k_) < 0) s = s_rvc;
+				sketches_[i] = hfunc (s, k_);
+			}
+			std::sort (sketches_.begin(), sketches_.end());
+
+			unsigned int v_sz = w_ * sizeof(uint64_t);
+			ss = hfunc (reinterpret_cast<const char*>(&sketches_[0]), v_sz);
+			for (int i = 1; i < num - w_ + 1; ++ i) {
+				ss = std::min (ss, hfunc (
+					reinterpret_cast<const char*>(&sketches_[i]), v_sz));
+			}
+			return true;
+		} // super_sketch
+
+	private:
+		int seed_len_, k_, w_;
+		int len_;
+		std::string frag_, rvc_frag_;
+		std::vector<int8_t> codes_;
+		std::vector<uint64_t> sketches_;
+		int counter_[5];
+		int8_t code_[256], comp_[256];
+		char rvc_[256];
+
+		void scan (const std::string& r, int offset, char n, char a) {
+			int sz = r.length();
+			if (sz == 0) return;
+			const unsigned char* p = (const unsigned char*) r.data();
+			char* f = &frag_[offset];
+			char* rc = &rvc_frag_[len_ - offset - 1];
+			int8_t* cd = &codes_[offset];
+			for (int i = 0; i < sz; ++ i) {
+				unsigned char c = p[i];
+				++ counter_[comp_[c]];
+				unsigned char b = (c == (unsigned char) n) ? a : c;
+				f[i] = b;
+				*(rc - i) = rvc_[b];
+				cd[i] = code_[b];
+			}
+		} // scan
+
+		int64_t seed (int pos, int len) const {
+			int64_t id = 0, rv = 0;
+			for (int j = 0; j < len; ++ j) {
+				int c = codes_[pos + j];
+				if (c < 0) return -1;
+				id = (id << 2) | c;
+			}
+			for (int j = pos + len - 1; j >= pos; -- j) {
+				rv = (rv << 2) | (3 - codes_[j]);
+			}
+			return std::max (id, rv);
+		} // seed
+	}; // class fragment_kernel
+
+} // namespace xny
+
+#endif /* FRAGMENT_KERNEL_HPP_ */
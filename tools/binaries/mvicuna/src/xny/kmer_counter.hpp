@@ -0,0 +1,136 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : kmer_counter.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Lock-free shared counting table of 64 bit k-mers
+//========================================================================
+
+
+#ifndef KMER_COUNTER_HPP_
+#define KMER_COUNTER_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include "../jaz/hash.hpp"
+
+namespace xny{
+	/**
+	 * Counter of 64 bit k-mers (k <= 32; the all-ones key, i.e. poly-T of
+	 * length 32, is reserved and must not be a canonical k-mer) shared by
+	 * threads without locks: an open addressing table with linear probing
+	 * whose slots are claimed by compare-and-swap and whose counts are
+	 * incremented atomically.
+	 *
+	 * The table does not grow while threads add to it; add() refuses a
+	 * new key once the load factor reaches 1/2 and the caller retries it
+	 * after reserve() between parallel regions.
+	 */
+	class kmer_counter {
+	public:
+		static const uint64_t empty_key = ~ (uint64_t) 0;
+
+		explicit kmer_counter (uint64_t expected = 1 << 16): size_ (0) {
+			init (expected);
+		}
+
+		/** Function: add ()
+		 *  Add [cnt] to the count of [key]; return false (nothing added)
+		 *  if [key] is new and the table is full. Thread safe.
+		 */
+		bool add (uint64_t key, uint32_t cnt = 1) {
+			uint64_t s = hash (key) & mask_;
+			while (true) {
+				uint64_t cur = __atomic_load_n (&keys_[s], __ATOMIC_ACQUIRE);
+				if (cur == empty_key) {
+					if (__atomic_load_n (&size_, __ATOMIC_RELAXED) >= limit_) {
+						return false;
+					}
+					cur = __sync_val_compare_and_swap (&keys_[s], empty_key, key);
+					if (cur == empty_key) {
+						__sync_fetch_and_add (&size_, 1);
+						cur = key;
+					}
+				}
+				if (cur == key) {
+					__sync_fetch_and_add (&counts_[s], cnt);
+					return true;
+				}
+				s = (s + 1) & mask_;
+			}
+		} // add
+
+		/** Function: count ()
+		 *  Return the count of [key], 0 if absent; not to be mixed with
+		 *  concurrent add()
+		 */
+		uint32_t count (uint64_t key) const {
+			uint64_t s = hash (key) & mask_;
+			while (keys_[s] != empty_key) {
+				if (keys_[s] == key) return counts_[s];
+				s = (s + 1) & mask_;
+			}
+			return 0;
+		} // count
+
+		/** Function: reserve ()
+		 *  Make room for [more] new keys on top of the current ones,
+		 *  rehashing if needed; not thread safe
+		 */
+		void reserve (uint64_t more) {
+			if (size_ + more <= limit_) return;
+			std::vector<uint64_t> keys;
+			std::vector<uint32_t> counts;
+			keys.swap (keys_);
+			counts.swap (counts_);
+			init (size_ + more);
+			for (size_t s = 0; s < keys.size(); ++ s) {
+				if (keys[s] == empty_key) continue;
+				uint64_t t = hash (keys[s]) & mask_;
+				while (keys_[t] != empty_key) t = (t + 1) & mask_;
+				keys_[t] = keys[s];
+				counts_[t] = counts[s];
+			}
+		} // reserve
+
+		/* number of distinct keys */
+		uint64_t size () const { return size_; }
+
+		/* slots, for iteration: key (s) == empty_key for unused slots */
+		uint64_t capacity () const { return keys_.size(); }
+		uint64_t key (uint64_t s) const { return keys_[s]; }
+		uint32_t count_at (uint64_t s) const { return counts_[s]; }
+
+	private:
+		uint64_t mask_, limit_, size_;
+		std::vector<uint64_t> keys_;
+		std::vector<uint32_t> counts_;
+
+		/* capacity: power of 2 >= 2 * [expected] */
+		void init (uint64_t expected) {
+			uint64_t cap = 1024;
+			while (cap < 2 * expected) cap *= 2;
+			mask_ = cap - 1;
+			limit_ = cap / 2;
+			keys_.assign (cap, (uint64_t) empty_key);
+			counts_.assign (cap, 0);
+		} // init
+
+		static uint64_t hash (uint64_t key) {
+			return jaz::mxs64 () (key);
+		}
+	}; // class kmer_counter
+
+} // namespace xny
+
+#endif /* KMER_COUNTER_HPP_ */
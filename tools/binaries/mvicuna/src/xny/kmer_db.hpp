@@ -0,0 +1,236 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : kmer_db.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Sorted, memory mapped file of k-mer counts
+//========================================================================
+
+
+#ifndef KMER_DB_HPP_
+#define KMER_DB_HPP_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+#if ! defined (_MSC_VER)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace xny{
+	/**
+	 * Sorted binary file of k-mer counts (k <= 32), queried in place
+	 * through a memory map, e.g. to reuse the counts of a library across
+	 * runs. Layout, all little endian:
+	 *
+	 *   header        64 bytes, see kmer_db_header
+	 *   index         2^index_bits + 1 uint64_t: position of the first
+	 *                 k-mer whose top index_bits bits are >= the slot
+	 *   keys          size uint64_t, ascending
+	 *   counts        size uint32_t, counts[i] of keys[i]
+	 *
+	 * kmer_db_writer takes the k-mers in ascending order and never holds
+	 * more than the index in memory.
+	 */
+	struct kmer_db_header {
+		char magic[8]; // "MVKMERDB"
+		uint32_t version;
+		uint32_t k;
+		uint32_t index_bits;
+		uint32_t canonical; // 1: each k-mer is the smaller of its two strands
+		uint64_t size; // number of k-mers
+		uint64_t total; // sum of the counts
+		uint64_t reserved[3];
+	}; // struct kmer_db_header
+
+	class kmer_db_writer {
+	public:
+		/** constructor kmer_db_writer ()
+		 *
+		 * Create [file] for exactly [size] k-mers of length [k]
+		 */
+		kmer_db_writer (const std::string& file, int k, bool canonical,
+				uint64_t size): pos_ (0), next_slot_ (0) {
+			std::memset (&hd_, 0, sizeof (hd_));
+			std::memcpy (hd_.magic, "MVKMERDB", 8);
+			hd_.version = 1;
+			hd_.k = k;
+			hd_.canonical = canonical;
+			hd_.size = size;
+			// about 16 k-mers per slot
+			uint32_t bits = 0;
+			while (bits < 24 && bits < 2 * (uint32_t) k &&
+					((uint64_t) 16 << bits) < size) ++ bits;
+			hd_.index_bits = bits;
+			index_.assign (((uint64_t) 1 << bits) + 1, 0);
+
+			{ // header, index and keys placeholders
+				std::ofstream fh (file.c_str(), std::ios::binary);
+				fh.write ((const char*) &hd_, sizeof (hd_));
+				fh.write ((const char*) &index_[0], index_.size() * sizeof (uint64_t));
+			}
+			keys_.open (file.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+			cnts_.open (file.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+			keys_.seekp (key_offset ());
+			cnts_.seekp (key_offset () + size * sizeof (uint64_t));
+		}
+
+		bool good () const { return keys_.good() && cnts_.good(); }
+
+		/** Function: add ()
+		 *  Append [key] with count [cnt]; keys must be added in ascending
+		 *  order
+		 */
+		void add (uint64_t key, uint32_t cnt) {
+			uint64_t slot = slot_of (key);
+			while (next_slot_ <= slot) index_[next_slot_ ++] = pos_;
+			keys_.write ((const char*) &key, sizeof (key));
+			cnts_.write ((const char*) &cnt, sizeof (cnt));
+			hd_.total += cnt;
+			++ pos_;
+		} // add
+
+		/** Function: close ()
+		 *  Write the header and the index; return false if fewer or more
+		 *  k-mers than announced were added or the file could not be
+		 *  written
+		 */
+		bool close () {
+			while (next_slot_ < index_.size()) index_[next_slot_ ++] = pos_;
+			keys_.seekp (0);
+			keys_.write ((const char*) &hd_, sizeof (hd_));
+			keys_.write ((const char*) &index_[0], index_.size() * sizeof (uint64_t));
+			bool ok = good () && pos_ == hd_.size;
+			keys_.close();
+			cnts_.close();
+			return ok;
+		} // close
+
+	private:
+		kmer_db_header hd_;
+		uint64_t pos_, next_slot_;
+		std::vector<uint64_t> index_;
+		std::fstream keys_, cnts_;
+
+		uint64_t key_offset () const {
+			return sizeof (hd_) + index_.size() * sizeof (uint64_t);
+		}
+
+		uint64_t slot_of (uint64_t key) const {
+			return hd_.index_bits ? key >> (2 * hd_.k - hd_.index_bits) : 0;
+		}
+	}; // class kmer_db_writer
+
+	class kmer_db {
+	public:
+		kmer_db (): data_ (NULL), bytes_ (0) {}
+
+		~kmer_db () { close (); }
+
+		/** Function: open ()
+		 *  Map [file]; return false if it is not a valid k-mer count file
+		 */
+		bool open (const std::string& file) {
+			close ();
+#if defined (_MSC_VER)
+			std::ifstream fh (file.c_str(), std::ios::binary | std::ios::ate);
+			if (! fh.good()) return false;
+			bytes_ = fh.tellg();
+			buf_.resize (bytes_ / sizeof (uint64_t) + 1);
+			fh.seekg (0);
+			fh.read ((char*) &buf_[0], bytes_);
+			data_ = (const char*) &buf_[0];
+#else
+			int fd = ::open (file.c_str(), O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (fstat (fd, &st) != 0 || st.st_size < (off_t) sizeof (hd_)) {
+				::close (fd);
+				return false;
+			}
+			bytes_ = st.st_size;
+			void* p = mmap (NULL, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+			::close (fd);
+			if (p == MAP_FAILED) {
+				bytes_ = 0;
+				return false;
+			}
+			data_ = (const char*) p;
+#endif
+			std::memcpy (&hd_, data_, sizeof (hd_));
+			uint64_t slots = ((uint64_t) 1 << hd_.index_bits) + 1;
+			if (std::memcmp (hd_.magic, "MVKMERDB", 8) != 0 || hd_.version != 1
+				|| hd_.k < 1 || hd_.k > 32 || hd_.index_bits > 2 * hd_.k
+				|| bytes_ != sizeof (hd_) + slots * sizeof (uint64_t) +
+					hd_.size * (sizeof (uint64_t) + sizeof (uint32_t))) {
+				close ();
+				return false;
+			}
+			index_ = (const uint64_t*) (data_ + sizeof (hd_));
+			keys_ = index_ + slots;
+			cnts_ = (const uint32_t*) (keys_ + hd_.size);
+			return true;
+		} // open
+
+		void close () {
+#if defined (_MSC_VER)
+			buf_.clear();
+#else
+			if (data_) munmap ((void*) data_, bytes_);
+#endif
+			data_ = NULL;
+			bytes_ = 0;
+		} // close
+
+		/** Function: count ()
+		 *  Return the count of [key], 0 if absent. Thread safe.
+		 */
+		uint32_t count (uint64_t key) const {
+			uint64_t slot = hd_.index_bits ?
+					key >> (2 * hd_.k - hd_.index_bits) : 0;
+			const uint64_t* b = keys_ + index_[slot];
+			const uint64_t* e = keys_ + index_[slot + 1];
+			const uint64_t* it = std::lower_bound (b, e, key);
+			return (it != e && *it == key) ? cnts_[it - keys_] : 0;
+		} // count
+
+		int k () const { return hd_.k; }
+		bool canonical () const { return hd_.canonical; }
+		uint64_t size () const { return hd_.size; }
+		uint64_t total () const { return hd_.total; }
+		uint64_t bytes () const { return bytes_; }
+
+	private:
+		kmer_db_header hd_;
+		const char* data_;
+		uint64_t bytes_;
+		const uint64_t* index_;
+		const uint64_t* keys_;
+		const uint32_t* cnts_;
+#if defined (_MSC_VER)
+		std::vector<uint64_t> buf_;
+#endif
+
+		kmer_db (const kmer_db&);
+		kmer_db& operator= (const kmer_db&);
+	}; // class kmer_db
+
+} // namespace xny
+
+#endif /* KMER_DB_HPP_ */
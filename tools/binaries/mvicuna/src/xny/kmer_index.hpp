@@ -0,0 +1,124 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : kmer_index.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Static open addressing index of k-mers to loci
+//========================================================================
+
+
+#ifndef KMER_INDEX_HPP_
+#define KMER_INDEX_HPP_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdint.h>
+#include "../jaz/hash.hpp"
+
+namespace xny{
+	/**
+	 * Static index of 64 bit k-mers (k <= 32) to lists of loci. Loci are
+	 * staged with insert(), then build() sorts them into one contiguous
+	 * array (per k-mer loci keep their insertion order) and fills an open
+	 * addressing table (linear probing, load factor <= 0.5) of
+	 * (k-mer, offset) slots. A lookup costs one hash and, for a miss,
+	 * typically a single probe into the slot array.
+	 */
+	template <typename loc_t>
+	class kmer_index {
+	public:
+		typedef std::pair<const loc_t*, const loc_t*> range_t;
+
+		kmer_index (): mask_(0) {}
+
+		/** Function: insert ()
+		 *  Stage locus [loc] of k-mer [key]; call build() afterwards
+		 */
+		void insert (uint64_t key, const loc_t& loc) {
+			staged_.push_back (std::make_pair (key, loc));
+		} // insert
+
+		/** Function: build ()
+		 *  Build the lookup table from the staged loci
+		 */
+		void build () {
+			std::stable_sort (staged_.begin(), staged_.end(),
+				[] (const std::pair<uint64_t, loc_t>& a,
+					const std::pair<uint64_t, loc_t>& b) {
+					return a.first < b.first; });
+
+			locs_.clear();
+			offsets_.clear();
+			std::vector<uint64_t> keys;
+			for (size_t i = 0; i < staged_.size(); ++ i) {
+				if (i == 0 || staged_[i].first != staged_[i - 1].first) {
+					keys.push_back (staged_[i].first);
+					offsets_.push_back (locs_.size());
+				}
+				locs_.push_back (staged_[i].second);
+			}
+			offsets_.push_back (locs_.size());
+			std::vector<std::pair<uint64_t, loc_t> >().swap (staged_);
+
+			uint64_t cap = 2;
+			while (cap < 2 * keys.size()) cap *= 2;
+			mask_ = cap - 1;
+			slots_.assign (cap, slot_t (0, -1));
+			for (size_t i = 0; i < keys.size(); ++ i) {
+				uint64_t s = hash (keys[i]) & mask_;
+				while (slots_[s].second != -1) s = (s + 1) & mask_;
+				slots_[s] = slot_t (keys[i], (int) i);
+			}
+		} // build
+
+		/** Function: find ()
+		 *  Return the loci of [key], an empty range if [key] is absent
+		 */
+		range_t find (uint64_t key) const {
+			if (slots_.empty()) return range_t (NULL, NULL);
+			uint64_t s = hash (key) & mask_;
+			while (slots_[s].second != -1) {
+				if (slots_[s].first == key) {
+					const loc_t* base = &locs_[0];
+					int i = slots_[s].second;
+					return range_t (base + offsets_[i], base + offsets_[i + 1]);
+				}
+				s = (s + 1) & mask_;
+			}
+			return range_t (NULL, NULL);
+		} // find
+
+		bool empty () const { return locs_.empty(); }
+
+		/* number of distinct k-mers */
+		size_t size () const {
+			return offsets_.empty() ? 0 : offsets_.size() - 1;
+		}
+
+	private:
+		typedef std::pair<uint64_t, int> slot_t; // (k-mer, key index)
+
+		uint64_t mask_;
+		std::vector<slot_t> slots_;
+		std::vector<size_t> offsets_;
+		std::vector<loc_t> locs_;
+		std::vector<std::pair<uint64_t, loc_t> > staged_;
+
+		static uint64_t hash (uint64_t key) {
+			return jaz::mxs64 () (key);
+		}
+	}; // class kmer_index
+
+} // namespace xny
+
+#endif /* KMER_INDEX_HPP_ */
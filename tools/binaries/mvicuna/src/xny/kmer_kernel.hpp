@@ -0,0 +1,176 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : kmer_kernel.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : k-mer extraction kernels specialised on k at compile time
+//========================================================================
+
+
+#ifndef KMER_KERNEL_HPP_
+#define KMER_KERNEL_HPP_
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace xny{
+	/**
+	 * k-mer extraction kernels specialised at compile time on k, on the
+	 * unsigned key type (k <= 4 * sizeof (key_t), i.e. k <= 32 for the
+	 * uint64_t keys used by Trim and SFrqEst) and on which strands are
+	 * reported, so masks and shifts are constants and the per base loop
+	 * has no branches on run time parameters. A kernel is selected once
+	 * for the run time k with select_kmer_kernel () and then called for
+	 * every sequence.
+	 *
+	 * Usage:
+	 *   typedef xny::bitkmer_kernel<uint64_t, xny::KMER_MIN, Iter> kernel_t;
+	 *   kernel_t::fn_t f = xny::select_kmer_kernel<kernel_t> (k);
+	 *   f (seq.data(), seq.length(), out);
+	 */
+
+	/* strands reported, same values as [code] of get_bitkmer () */
+	enum kmer_strand { KMER_MIN = 0, KMER_MAX = 1, KMER_BOTH = 2,
+		KMER_FWD = 3, KMER_RVC = 4 };
+
+	/* 2 bit code of ACGTacgt, -1 for any other char */
+	inline const int8_t* kmer_code_table () {
+		struct table_t {
+			int8_t code[256];
+			table_t () {
+				for (int c = 0; c < 256; ++ c) code[c] = -1;
+				const char* acgt = "ACGTacgt";
+				for (int i = 0; i < 8; ++ i) {
+					code[(unsigned char) acgt[i]] = i % 4;
+				}
+			}
+		};
+		static const table_t table;
+		return table.code;
+	} // kmer_code_table
+
+	/* rolling forward and reverse complementary k-mer of [K] bases */
+	template <typename key_t, int K>
+	struct kmer_roller {
+		key_t fwd, rvc;
+		int run; // number of consecutive ACGT bases seen
+
+		kmer_roller (): fwd (0), rvc (0), run (0) {}
+
+		static key_t mask () {
+			return (2 * K >= (int) (8 * sizeof (key_t))) ?
+				~ (key_t) 0 : (((key_t) 1 << (2 * K)) - 1);
+		}
+
+		/* add a base of code [c], return true once a full k-mer is seen */
+		bool add (int c) {
+			if (c < 0) {
+				run = 0;
+				return false;
+			}
+			fwd = ((fwd << 2) | (key_t) c) & mask ();
+			rvc = (rvc >> 2) | ((key_t) (3 - c) << (2 * (K - 1)));
+			return ++ run >= K;
+		}
+	}; // struct kmer_roller
+
+	/**
+	 * All k-mers (including duplicated ones) of a sequence, in the order
+	 * and strand choice of get_bitkmer () with code [CODE]; k-mers with
+	 * non-ACGT chars are skipped
+	 */
+	template <typename key_t, int CODE, typename outputIter>
+	struct bitkmer_kernel {
+		typedef void (*fn_t) (const char*, int, outputIter);
+		static const int max_k = 4 * sizeof (key_t);
+
+		template <int K>
+		static void run (const char* seq, int len, outputIter out) {
+			const int8_t* code = kmer_code_table ();
+			kmer_roller<key_t, K> roll;
+			for (int i = 0; i < len; ++ i) {
+				if (! roll.add (code[(unsigned char) seq[i]])) continue;
+				switch (CODE) {
+				case KMER_MIN:
+					*out = (roll.rvc < roll.fwd) ? roll.rvc : roll.fwd; ++ out;
+					break;
+				case KMER_MAX:
+					*out = (roll.rvc < roll.fwd) ? roll.fwd : roll.rvc; ++ out;
+					break;
+				case KMER_BOTH:
+					*out = roll.fwd; ++ out;
+					*out = roll.rvc; ++ out;
+					break;
+				case KMER_FWD:
+					*out = roll.fwd; ++ out;
+					break;
+				default:
+					*out = roll.rvc; ++ out;
+				}
+			}
+		} // run
+	}; // struct bitkmer_kernel
+
+	/**
+	 * k-mers indexed by start position, see get_bitkmer_by_pos (): [fwd],
+	 * [rvc] (may be NULL) and [valid] hold len - k + 1 (> 0) entries
+	 */
+	template <typename key_t>
+	struct bitkmer_pos_kernel {
+		typedef void (*fn_t) (const char*, int, key_t*, key_t*, char*);
+		static const int max_k = 4 * sizeof (key_t);
+
+		template <int K>
+		static void run (const char* seq, int len, key_t* fwd, key_t* rvc,
+				char* valid) {
+			const int8_t* code = kmer_code_table ();
+			kmer_roller<key_t, K> roll;
+			for (int i = 0; i < len - K + 1; ++ i) valid[i] = 0;
+			for (int i = 0; i < len; ++ i) {
+				if (! roll.add (code[(unsigned char) seq[i]])) continue;
+				int pos = i - K + 1;
+				fwd[pos] = roll.fwd;
+				if (rvc) rvc[pos] = roll.rvc;
+				valid[pos] = 1;
+			}
+		} // run
+	}; // struct bitkmer_pos_kernel
+
+	/* fill [table][K] ... [table][1] with the specialisations of a kernel */
+	template <typename kernel_t, int K>
+	struct kmer_kernel_table {
+		static void fill (typename kernel_t::fn_t* table) {
+			table[K] = &kernel_t::template run<K>;
+			kmer_kernel_table<kernel_t, K - 1>::fill (table);
+		}
+	};
+
+	template <typename kernel_t>
+	struct kmer_kernel_table<kernel_t, 0> {
+		static void fill (typename kernel_t::fn_t*) {}
+	};
+
+	/** Function: select_kmer_kernel ()
+	 *  Return the specialisation of [kernel_t] for [k], NULL if k is out
+	 *  of the range [1, kernel_t::max_k]
+	 */
+	template <typename kernel_t>
+	typename kernel_t::fn_t select_kmer_kernel (int k) {
+		if (k < 1 || k > kernel_t::max_k) return NULL;
+		typename kernel_t::fn_t table[kernel_t::max_k + 1];
+		kmer_kernel_table<kernel_t, kernel_t::max_k>::fill (table);
+		return table[k];
+	} // select_kmer_kernel
+
+} // namespace xny
+
+#endif /* KMER_KERNEL_HPP_ */
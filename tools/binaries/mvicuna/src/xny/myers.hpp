@@ -0,0 +1,112 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : myers.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Myers bit-parallel approximate matching of primers
+//========================================================================
+
+
+#ifndef MYERS_HPP_
+#define MYERS_HPP_
+
+#include <string>
+#include <cctype>
+#include <algorithm>
+#include <stdint.h>
+
+namespace xny{
+	/**
+	 * Myers' bit-vector approximate string matching (Myers 1999, in the
+	 * formulation of Hyyro) of one pattern of at most 64 bases against a
+	 * text, edit distance (mismatches and indels), case insensitive.
+	 * The pattern may start anywhere in the text.
+	 *
+	 * One scan of the text reports
+	 * -- the leftmost end position of an occurrence of the whole pattern
+	 * 	  with at most [max_err] errors
+	 * -- the longest pattern prefix of length >= [min_len] aligning to the
+	 * 	  end of the text with at most max_err * len / pattern_len errors
+	 * The text is read backwards when the matcher is built with
+	 * [reverse] = true (pattern is then given reversed as well), which
+	 * finds pattern suffixes at the beginning of the text.
+	 */
+	class myers_matcher {
+	public:
+		/** constructor myers_matcher ()
+		 *
+		 * [p]: pattern of length [m] (longer patterns are cut to 64)
+		 */
+		myers_matcher (const char* p, int m, bool reverse):
+			reverse_(reverse) {
+			m_ = std::min (m, 64);
+			std::fill (peq_, peq_ + 256, 0);
+			for (int i = 0; i < m_; ++ i) {
+				unsigned char c = std::toupper (p[i]);
+				peq_[c] |= (uint64_t) 1 << i;
+				peq_[std::tolower (c)] |= (uint64_t) 1 << i;
+			}
+			mask_ = (m_ == 64) ? ~ (uint64_t) 0 : (((uint64_t) 1 << m_) - 1);
+		}
+
+		int length () const { return m_; }
+
+		bool reverse () const { return reverse_; }
+
+		/** Function: scan ()
+		 *
+		 * Scan text [t] of length [n]. [end]: leftmost end position
+		 * (w.r.t. the scan direction) of a full pattern occurrence, -1 if
+		 * none; [ovl]: length of the longest pattern prefix aligning to
+		 * the last scanned base, 0 if none
+		 */
+		void scan (const char* t, int n, int max_err, int min_len,
+				int& end, int& ovl) const {
+			end = -1;
+			ovl = 0;
+			if (m_ == 0) return;
+			uint64_t pv = mask_, mv = 0, high = (uint64_t) 1 << (m_ - 1);
+			int score = m_;
+			for (int j = 0; j < n; ++ j) {
+				unsigned char c = reverse_ ? t[n - j - 1] : t[j];
+				uint64_t eq = peq_[c];
+				uint64_t xv = eq | mv;
+				uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+				uint64_t ph = mv | ~ (xh | pv);
+				uint64_t mh = pv & xh;
+				if (ph & high) ++ score;
+				else if (mh & high) -- score;
+				ph <<= 1;
+				mh <<= 1;
+				pv = (mh | ~ (xv | ph)) & mask_;
+				mv = ph & xv;
+				if (end == -1 && score <= max_err) end = j;
+			}
+
+			// last column: D[i] = D[i - 1] + pv_i - mv_i, D[0] = 0
+			int d = 0;
+			for (int i = 1; i <= m_; ++ i) {
+				d += (int) ((pv >> (i - 1)) & 1) - (int) ((mv >> (i - 1)) & 1);
+				if (i >= min_len && d <= max_err * i / m_) ovl = i;
+			}
+		} // scan
+
+	private:
+		int m_;
+		bool reverse_;
+		uint64_t mask_;
+		uint64_t peq_[256];
+	}; // class myers_matcher
+
+} // namespace xny
+
+#endif /* MYERS_HPP_ */
@@ -62,6 +62,35 @@ namespace xny{
 		return idx;
 	} // common_suf_len
 
+	/** Function common_pref_len ()
+	 * length of common prefix between [s0] of length [len0] and [s1] of
+	 * length [len1]
+	 */
+	inline int common_pref_len (const char* s0, int len0,
+			const char* s1, int len1) {
+		int len = std::min(len0, len1);
+		int idx = 0;
+		for (; idx < len; ++ idx) {
+			if (toupper(s0[idx]) != toupper(s1[idx])) return idx;
+		}
+		return idx;
+	} // common_pref_len
+
+	/** Function common_suf_len ()
+	 * length of common suffix between [s0] of length [len0] and [s1] of
+	 * length [len1]
+	 */
+	inline int common_suf_len (const char* s0, int len0,
+			const char* s1, int len1) {
+		int mlen = std::min(len0, len1);
+		int idx = 0;
+		for (; idx < mlen; ++ idx) {
+			if (toupper (s0[len0 - idx - 1]) != toupper(s1[len1 - idx - 1]))
+				return idx;
+		}
+		return idx;
+	} // common_suf_len
+
 	/** Function hd ()
 	 *
 	 * Calculate Hamming distance between two DNA strings
@@ -119,6 +148,17 @@ namespace xny{
 	/**
 	 * Functor implementation of suffix prefix gap free alignment between
 	 * DNA strings s0 and s1
+	 *
+	 * Both strings are 2-bit packed, 32 bases a 64 bit word, and the
+	 * mismatches of every offset of s1 against s0 are counted by XOR and
+	 * popcount of the packed words; N (any non-ACGT char) matches anything.
+	 * At each offset [max_overhang_] bases are left out on both ends of
+	 * the overlap. An offset is valid if the rest is >= [min_len_] long
+	 * with identity >= [min_perc_identi_]; the valid offset with the most
+	 * matching bases wins, ties going to fewer mismatches. The word
+	 * buffers are reused between calls, so a copy per thread is needed.
+	 * s1 may be given as the reverse complement of a read, which is then
+	 * never materialised.
 	 */
 	class suffix_prefix_gap_free_aln {
 	public:
@@ -133,77 +173,102 @@ namespace xny{
       	 */
 		coord_t operator() (const std::string& s0,
 				const std::string& s1) {
+			return (*this) (s0.data(), s0.length(), s1.data(), s1.length(),
+					false);
+		} // operator()
 
-			int seed = 7;
-
-			int l0 = s0.length(), l1 = s1.length();
-			std::map<int, ipair_t> kID2pos;
-			// dividing s0 into non-overlapping seed-mers
-			// while neglecting the overhang in the suffix
-			int num_sevn_mer = (l0 - max_overhang_)/7;
-			int start = l0 - num_sevn_mer * seed - max_overhang_;
-			char* addr = const_cast<char*> (s0.c_str());
-			for (int i = 0; i < num_sevn_mer; ++ i) {
-				uint32_t ID;
-				if (xny::str2ID<uint32_t> (ID, addr + start, seed)) {
-					kID2pos[ID] = ipair_t (start, -1);
-				}
-				start += seed;
-			}
-			// go through s1, identify common seed-mers shared with s0
-			addr = const_cast<char*> (s1.c_str());
-			for (int l = 0; l < l1 - seed + 1; ++ l) {
-				uint32_t ID;
-				if (xny::str2ID<uint32_t> (ID, addr + l, seed)) {
-					std::map<int, ipair_t>::iterator it = kID2pos.find(ID);
-					if (it != kID2pos.end()) {
-						it->second.second = l;
-					}
-				}
-			}
-			// now anchored by each common seed, check validity of alignment
-			//        /
-			// -------
-			//    ---------
-			//   /
-			std::map<int, ipair_t>::iterator it = kID2pos.begin();
-			for (; it != kID2pos.end(); ++ it) {
-				int p0_seed = it->second.first, p1_seed = it->second.second;
-				if (p1_seed != -1) { // common seed found
-					int lcmplen = std::min(p1_seed - max_overhang_,
-							p0_seed - max_overhang_),
-					rcmplen = std::min(l1 - p1_seed - seed - max_overhang_,
-								l0 - p0_seed - seed - max_overhang_),
-					maxhd = (lcmplen + rcmplen + seed)*(100 - min_perc_identi_)/100;
-
-					// min_len_ criterion
-					if (lcmplen + rcmplen + seed < min_len_) continue;
-					// left side of seed
-					int l_hd = 0, r_hd = 0;
-					if (lcmplen > 0) {
-						l_hd = hdlet (s0.substr(p0_seed - lcmplen, lcmplen),
-								s1.substr(p1_seed - lcmplen, lcmplen), maxhd);
-						if (l_hd == -1) continue;
-					}
-					if (rcmplen > 0) {
-						r_hd = hdlet (s0.substr(p0_seed + seed, rcmplen),
-								s1.substr(p1_seed + seed, rcmplen), maxhd);
-						if (r_hd == -1) continue;
-					}
-					if (l_hd + r_hd <= maxhd) { // valid alignment
-						return std::make_tuple (p0_seed - lcmplen,
-								p0_seed + seed + rcmplen - 1, p1_seed - lcmplen,
-								p1_seed + seed + rcmplen - 1);
-					}
+		/** Function: operator()
+		 *  Same as above for s0 of length [l0] and s1 of length [l1], s1
+		 *  is the reverse complement of [s1] if [rvc1]; coordinates on s1
+		 *  refer to that reverse complement.
+		 */
+		coord_t operator() (const char* s0, int l0, const char* s1, int l1,
+				bool rvc1) {
+
+			pack (bits0_, acgt0_, s0, l0, false);
+			pack (bits1_, acgt1_, s1, l1, rvc1);
+
+			int best_score = -1, best_hd = 0, best_d = 0, best_b = 0,
+				best_e = 0;
+			// s1[j] is aligned to s0[j + d]
+			for (int d = l0 - 1; d > - l1; -- d) {
+				int b = std::max (0, - d) + max_overhang_,
+					e = std::min (l1, l0 - d) - max_overhang_,
+					len = e - b;
+				// len bounds the score: skip unless it can win
+				if (len < min_len_ || len < best_score) continue;
+
+				int maxhd = len * (100 - min_perc_identi_) / 100;
+				int limit = std::min (maxhd, len - best_score);
+				int hd = mismatches (b + d, b, len, limit);
+				if (hd > limit) continue;
+
+				int score = len - hd;
+				if (score > best_score || (score == best_score && hd < best_hd)) {
+					best_score = score;
+					best_hd = hd;
+					best_d = d;
+					best_b = b;
+					best_e = e;
 				}
-			} // for
-			return std::make_tuple(-1, -1, -1, -1);
+			} // for d
+
+			if (best_score == -1) return std::make_tuple(-1, -1, -1, -1);
+			return std::make_tuple (best_b + best_d, best_e + best_d - 1,
+					best_b, best_e - 1);
 		} // std::tuple<int, int, int, int> operator()
 
 	private:
 		int min_len_;
 		int min_perc_identi_;
 		int max_overhang_;
+		std::vector<uint64_t> bits0_, acgt0_, bits1_, acgt1_;
+
+		/* 2-bit codes of [seq] (its reverse complement if [rvc]) into
+		 * [bits] and 11 per ACGT base in [acgt]; one zero word of padding
+		 * so that unaligned reads stay in range
+		 */
+		static void pack (std::vector<uint64_t>& bits,
+				std::vector<uint64_t>& acgt, const char* seq, int len,
+				bool rvc) {
+			int num_words = len / 32 + 2;
+			if ((int) bits.size() < num_words) {
+				bits.resize (num_words);
+				acgt.resize (num_words);
+			}
+			std::fill (bits.begin(), bits.begin() + num_words, 0);
+			std::fill (acgt.begin(), acgt.begin() + num_words, 0);
+			const int8_t* code = kmer_code_table ();
+			for (int i = 0; i < len; ++ i) {
+				int c = rvc ? code[(unsigned char) seq[len - i - 1]] :
+						code[(unsigned char) seq[i]];
+				if (c < 0) continue;
+				if (rvc) c = 3 - c;
+				bits[i / 32] |= (uint64_t) c << (2 * (i % 32));
+				acgt[i / 32] |= (uint64_t) 3 << (2 * (i % 32));
+			}
+		} // pack
+
+		/* 32 bases of a packed string starting at base [pos] */
+		static uint64_t word_at (const std::vector<uint64_t>& w, int pos) {
+			int i = pos / 32, sh = 2 * (pos % 32);
+			if (sh == 0) return w[i];
+			return (w[i] >> sh) | (w[i + 1] << (64 - sh));
+		} // word_at
+
+		/* mismatches of s0[p0, p0 + len) vs s1[p1, p1 + len), counting
+		 * stops once > [limit]
+		 */
+		int mismatches (int p0, int p1, int len, int limit) const {
+			int hd = 0;
+			for (int i = 0; i < len && hd <= limit; i += 32) {
+				uint64_t x = (word_at (bits0_, p0 + i) ^ word_at (bits1_, p1 + i))
+						& word_at (acgt0_, p0 + i) & word_at (acgt1_, p1 + i);
+				if (len - i < 32) x &= ((uint64_t) 1 << (2 * (len - i))) - 1;
+				hd += __builtin_popcountll ((x | (x >> 1)) & 0x5555555555555555ULL);
+			}
+			return hd;
+		} // mismatches
 	}; // class suffix_prefix_gap_free_aln
 
 
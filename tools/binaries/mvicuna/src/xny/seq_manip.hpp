@@ -32,6 +32,11 @@ http://www.sgi.com/tech/stl/stl_introduction.html
 #include <vector>
 #include <algorithm>
 #include <stdint.h>
+#include "kmer_kernel.hpp"
+#include "xny/seq_kernel.hpp"
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace xny{
 	/**
@@ -45,31 +50,47 @@ namespace xny{
 	class low_complexity {
 	public:
 		low_complexity (int freq_n, int freq_mono, int freq_di):
-			freq_n_(freq_n), freq_mono_(freq_mono), freq_di_(freq_di) { }
+			freq_n_(freq_n), freq_mono_(freq_mono), freq_di_(freq_di) {
+			std::fill (idx_, idx_ + 256, 4);
+			const char* acgt = "ACGTacgt";
+			for (int i = 0; i < 8; ++ i) idx_[(unsigned char) acgt[i]] = i % 4;
+		}
 
 		/** Function: operator()
 		 *  Return true if s is of low complexity
 		 */
-		bool operator() (const std::string& s){
-			ivec_t counter (5, 0);
-			int len = s.length();
+		bool operator() (const std::string& s) const {
+			return (*this) (s.data(), s.length());
+		} // bool operator()
+
+		/** Function: operator()
+		 *  Return true if the [len] bases starting at [s] are of low
+		 *  complexity
+		 */
+		bool operator() (const char* s, int len) const {
+			int counter[5] = {0, 0, 0, 0, 0};
+			count (s, len, counter);
+			return (*this) (counter, len);
+		} // bool operator()
+
+		/** Function: operator()
+		 *  Return true if a sequence of length [len] with [counter] A, C,
+		 *  G, T and other bases is of low complexity
+		 */
+		bool operator() (const int* counter, int len) const {
 			if (len == 0) return true;
-			for (int i = 0; i < len; ++ i) {
-				switch (toupper (s.at(i))) {
-				case 'A':	++ counter[0];	break;
-				case 'C':	++ counter[1];	break;
-				case 'G':	++ counter[2];	break;
-				case 'T':	++ counter[3];	break;
-				default:		++ counter[4];	break;
-				}
+			// two largest counts by selection
+			int top = 0, second = 0;
+			for (int i = 0; i < 5; ++ i) {
+				if (counter[i] > top) {
+					second = top;
+					top = counter[i];
+				} else if (counter[i] > second) second = counter[i];
 			}
 
-			ivec_t sorted = counter;
-			std::sort (sorted.begin(), sorted.end());
-
 			int n = 100*counter[4]/len;
-			int mono = 100*sorted[4]/len;
-			int di = 100*(sorted[4] + sorted[3])/len;
+			int mono = 100*top/len;
+			int di = 100*(top + second)/len;
 
 		//	std::cout << n << "\t" <<  mono << "\t" << di << "\n";
 			if (n >= freq_n_ || mono >= freq_mono_ || di >= freq_di_) {
@@ -79,12 +100,90 @@ namespace xny{
 			return false;
 		} // bool operator()
 
+		/** Function: count ()
+		 *  Add the numbers of A, C, G, T (case insensitive) and other bases
+		 *  among the [len] bases starting at [s] to [counter]
+		 */
+		void count (const char* s, int len, int* counter) const {
+			int acgt[4] = {0, 0, 0, 0};
+			int i = 0;
+#if defined (__SSE2__)
+			// 16 bases at a time: case folded byte compares are
+			// accumulated in 8 bit lanes, which are summed (psadbw)
+			// before they can overflow
+			const __m128i fold = _mm_set1_epi8 (0x20), zero = _mm_setzero_si128();
+			const __m128i base[4] = { _mm_set1_epi8 ('a'),
+				_mm_set1_epi8 ('c'), _mm_set1_epi8 ('g'), _mm_set1_epi8 ('t') };
+			while (i + 16 <= len) {
+				__m128i acc[4] = { zero, zero, zero, zero };
+				int stop = std::min (len - 15, i + 255 * 16);
+				for (; i < stop; i += 16) {
+					__m128i v = _mm_or_si128 (fold,
+						_mm_loadu_si128 (reinterpret_cast<const __m128i*> (s + i)));
+					for (int b = 0; b < 4; ++ b) {
+						acc[b] = _mm_sub_epi8 (acc[b], _mm_cmpeq_epi8 (v, base[b]));
+					}
+				}
+				for (int b = 0; b < 4; ++ b) {
+					__m128i sum = _mm_sad_epu8 (acc[b], zero);
+					acgt[b] += _mm_cvtsi128_si32 (sum) +
+							_mm_cvtsi128_si32 (_mm_srli_si128 (sum, 8));
+				}
+			}
+#endif
+			int tail[5] = {0, 0, 0, 0, 0};
+			for (; i < len; ++ i) ++ tail[idx_[(unsigned char) s[i]]];
+			int num_acgt = 0;
+			for (int b = 0; b < 4; ++ b) {
+				counter[b] += acgt[b] + tail[b];
+				num_acgt += acgt[b] + tail[b];
+			}
+			counter[4] += len - num_acgt;
+		} // count
+
 	private:
 		int freq_n_;    // freq of Ns
 		int freq_mono_;  // single nucleotide frequency
 		int freq_di_; 	// dinucleotide frequency
+		int8_t idx_[256]; // base -> counter index
 	}; // class low_complexity
 
+	/** Function first_above ()
+	 *  Index of the first of the [len] chars at [s] that is greater than
+	 *  [thr] (signed char compare), [len] if there is none
+	 */
+	inline int first_above (const char* s, int len, int thr) {
+		if (thr >= 127) return len;
+		int i = 0;
+#if defined (__SSE2__)
+		const __m128i t = _mm_set1_epi8 ((char) std::max (thr, -128));
+		for (; i + 16 <= len; i += 16) {
+			__m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (s + i));
+			if (_mm_movemask_epi8 (_mm_cmpgt_epi8 (v, t))) break;
+		}
+#endif
+		for (; i < len; ++ i) if ((int) (signed char) s[i] > thr) return i;
+		return len;
+	} // first_above
+
+	/** Function last_above ()
+	 *  Index of the last of the [len] chars at [s] that is greater than
+	 *  [thr] (signed char compare), -1 if there is none
+	 */
+	inline int last_above (const char* s, int len, int thr) {
+		if (thr >= 127) return -1;
+		int i = len;
+#if defined (__SSE2__)
+		const __m128i t = _mm_set1_epi8 ((char) std::max (thr, -128));
+		for (; i >= 16; i -= 16) {
+			__m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (s + i - 16));
+			if (_mm_movemask_epi8 (_mm_cmpgt_epi8 (v, t))) break;
+		}
+#endif
+		for (-- i; i >= 0; -- i) if ((int) (signed char) s[i] > thr) return i;
+		return -1;
+	} // last_above
+
 	inline char bits2char(int value) {
 		switch (value) {
         case 0:
@@ -100,25 +199,26 @@ namespace xny{
 		}
 	}
 
+	/* 2 bit code of ACGTacgt, -1 for any other char */
 	inline int char2bits (char c) {
-		int cvalue = -1;
-		switch (std::toupper(c)) {
-			case 'A':
-				cvalue = 0;
-				break;
-			case 'C':
-				cvalue = 1;
-				break;
-			case 'G':
-				cvalue = 2;
-				break;
-			case 'T':
-				cvalue = 3;
+		int cvalue = seq_code_table ()[(unsigned char) c];
+		return cvalue < 4 ? cvalue : -1;
+	} // char2bits
+
+	/* true if [s] is not empty and made of ACGTN only, any case */
+	inline bool is_nt (const std::string& s) {
+		if (s.empty()) return false;
+		for (auto c: s) {
+			switch (c) {
+			case 'A': case 'C': case 'G': case 'T': case 'N':
+			case 'a': case 'c': case 'g': case 't': case 'n':
 				break;
+			default:
+				return false;
+			}
 		}
-		if (cvalue != -1) return cvalue;
-		else return -1;
-	} // char2bits
+		return true;
+	} // is_nt
 
 	inline void remove_gap (std::string& seq) {
 		std::string::iterator it_end =
@@ -233,52 +333,19 @@ namespace xny{
 	 * to its reverse complementary; the result is stored in another string.
 	 * All non-ACGTacgt characters will be returned as 'n'
 	 */
-	inline std::string get_rvc_str (std::string fwd) {
-		std::reverse(fwd.begin(), fwd.end());
-		for (int i = 0; i < (int) fwd.length(); ++ i) {
-			fwd[i] = get_rvc_base (fwd[i]);
-		}
-		return fwd;
+	inline std::string get_rvc_str (const std::string& fwd) {
+		std::string rvc (fwd.length(), 'n');
+		if (! fwd.empty()) seq_rvc (fwd.data(), fwd.length(), &rvc[0], 'n');
+		return rvc;
 	} // get_rvc_str
 
 	/* @brief 	The input DNA string [fwd] is converted to its rvc, the
 	 * 			result is stored in [fwd].
-	 * @note		All non-ACGTacgt characters will be returned as 'n'
+	 * @note		All non-ACGTacgt characters will be returned as 'N'
 	 */
 	inline void rvc_str (std::string& fwd) {
-		std::reverse(fwd.begin(), fwd.end());
-		for (int i = 0; i < (int) fwd.length(); ++ i){
-			switch (fwd.at(i)){
-			case 'A':
-				fwd[i] = 'T';
-				break;
-			case 'T':
-				fwd[i] = 'A';
-				break;
-			case 'C':
-				fwd[i] = 'G';
-				break;
-			case 'G':
-				fwd[i] = 'C';
-				break;
-			case 'a':
-				fwd[i] = 't';
-				break;
-			case 't':
-				fwd[i] = 'a';
-				break;
-			case 'c':
-				fwd[i] = 'g';
-				break;
-			case 'g':
-				fwd[i] = 'c';
-				break;
-			default:
-				fwd[i] = 'N';
-				break;
-			}
-		}
-	} // get_rvc_str
+		if (! fwd.empty()) seq_rvc (&fwd[0], fwd.length(), &fwd[0], 'N');
+	} // rvc_str
 	/*
 	 * extract all kmers (including duplicated ones) in bit form from a
 	 * DNA sequence, including forward and/or reverse complementary
@@ -292,100 +359,73 @@ namespace xny{
 	 * 		 4: only rv strand rv0 rv1 ...rv_i, i is w.r.t the fwd strand
 	 *
 	 * Usage: xny::get_bitkmer<std::back_insert_iterator<Container_t>, out_t>()
+	 *
+	 * The k-specialised kernel of kmer_kernel.hpp is looked up on every
+	 * call; loops over many sequences should select it once instead.
 	 */
 	template <typename outputIter, typename out_t>
-	void get_bitkmer (const std::string& seq,
+	void get_bitkmer (const char* seq, int seq_len,
 			outputIter out, int k, int code) {
 
-		if (k > (int) seq.length()) return;
-		// lowest 2k bits = 1
-		out_t MaskLowerKbits = (out_t) pow(2, 2*k) - 1;
-		std::vector<out_t> MaskTop2bits(4, 0);
-		for (out_t i = 1; i < 4; ++ i){
-			MaskTop2bits[i] = (i << (2*(k - 1)));
+		if (k > seq_len) return;
+		if (k < 1 || k > (int) (4 * sizeof (out_t))) {
+			std::cout << "In func get_bitkmer, [k] out of range\n";
+			exit(1);
 		}
-		std::reverse(MaskTop2bits.begin(), MaskTop2bits.end()); // t g c a
-
-		char* addr = const_cast<char*> (seq.c_str());
-		int len = (int) seq.length() - k + 1;
-
-		out_t ID = 0, rcID = 0;
-		int j = 0;
-		bool flag = false; //true: the previous kmer contains no Ns
-		while (j < len){
-			if (flag){
-				int c = char2bits (*(addr + j + k -1));
-				if (c == -1) {
-					j += k;
-					flag = false;
-				}
-				else {
-					ID  = ((ID << 2 | c) & MaskLowerKbits);
-					rcID = (rcID >> 2);
-					rcID |= MaskTop2bits[c];
-
-					switch (code) {
-					case 0:
-						if (rcID < ID) { *out = rcID; ++ out; }
-						else  {	*out = ID; ++ out; }
-						break;
-					case 1:
-						if (rcID < ID) { *out = ID; ++ out; }
-						else  {	*out = rcID; ++ out; }
-						break;
-					case 2:
-						*out = ID; ++ out;
-						*out = rcID; ++ out;
-						break;
-					case 3:
-						*out = ID; ++ out;
-						break;
-					case 4:
-						*out = rcID; ++ out;
-						break;
-					default:
-						std::cout << "In func get_bitkmer, [code] out of range\n";
-						exit(1);
-					}
-
-					++ j;
-				}
-			}
-			else{
-				if (str2ID (ID, addr + j, k)) {
-					rcID = get_rvc_bits <out_t> (ID, k);
-					flag = true;
-
-					switch (code) {
-					case 0:
-						if (rcID < ID) { *out = rcID; ++ out; }
-						else  {	*out = ID; ++ out; }
-						break;
-					case 1:
-						if (rcID < ID) { *out = ID; ++ out; }
-						else  {	*out = rcID; ++ out; }
-						break;
-					case 2:
-						*out = ID; ++ out;
-						*out = rcID; ++ out;
-						break;
-					case 3:
-						*out = ID; ++ out;
-						break;
-					case 4:
-						*out = rcID; ++ out;
-						break;
-					default:
-						std::cout << "In func get_bitkmer, [code] out of range\n";
-						exit(1);
-					}
-
-				}
-				++ j;
-			}
+		switch (code) {
+		case 0:
+			select_kmer_kernel<bitkmer_kernel<out_t, KMER_MIN, outputIter> >
+				(k) (seq, seq_len, out);
+			break;
+		case 1:
+			select_kmer_kernel<bitkmer_kernel<out_t, KMER_MAX, outputIter> >
+				(k) (seq, seq_len, out);
+			break;
+		case 2:
+			select_kmer_kernel<bitkmer_kernel<out_t, KMER_BOTH, outputIter> >
+				(k) (seq, seq_len, out);
+			break;
+		case 3:
+			select_kmer_kernel<bitkmer_kernel<out_t, KMER_FWD, outputIter> >
+				(k) (seq, seq_len, out);
+			break;
+		case 4:
+			select_kmer_kernel<bitkmer_kernel<out_t, KMER_RVC, outputIter> >
+				(k) (seq, seq_len, out);
+			break;
+		default:
+			std::cout << "In func get_bitkmer, [code] out of range\n";
+			exit(1);
 		}
 	} // get_bitkmer
 
+	template <typename outputIter, typename out_t>
+	void get_bitkmer (const std::string& seq,
+			outputIter out, int k, int code) {
+		get_bitkmer<outputIter, out_t> (seq.data(), seq.length(), out, k, code);
+	} // get_bitkmer
+
+	/*
+	 * extract the kmers in bit form of a DNA sequence [seq] of length
+	 * [seq_len] indexed by their start position: [fwd][i] (and [rvc][i]
+	 * for the reverse complementary strand when [rvc] is not NULL) is the
+	 * kmer starting at i, valid only if [valid][i] is set, i.e. the kmer
+	 * consists of ACGTacgt only. All vectors get size seq_len - k + 1.
+	 */
+	template <typename out_t>
+	void get_bitkmer_by_pos (const char* seq, int seq_len, int k,
+			std::vector<out_t>& fwd, std::vector<out_t>* rvc,
+			std::vector<char>& valid) {
+		int num = std::max (seq_len - k + 1, 0);
+		fwd.resize (num);
+		valid.resize (num);
+		if (rvc) rvc->resize (num);
+		if (num == 0) return;
+
+		select_kmer_kernel<bitkmer_pos_kernel<out_t> > (k) (seq, seq_len,
+				&fwd[0], rvc ? &(*rvc)[0] : NULL, &valid[0]);
+	} // get_bitkmer_by_pos
+
 	/********************************************************************
 	 * extract all kmers (including duplicated ones) in string form from a
 	 * DNA sequence, including both forward and reverse complementary
@@ -409,8 +449,8 @@ namespace xny{
 		std::string kmer, rcKmer;
 		kmer = seq.substr(0, k);
 		rcKmer = get_rvc_str (kmer);
-		std::transform(kmer.begin(), kmer.end(), kmer.begin(), toupper);
-		std::transform(rcKmer.begin(), rcKmer.end(), rcKmer.begin(), toupper);
+		seq_upper (&kmer[0], kmer.length());
+		seq_upper (&rcKmer[0], rcKmer.length());
 
 		switch (code) {
 			case 0:
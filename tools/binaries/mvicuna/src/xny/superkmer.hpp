@@ -0,0 +1,179 @@
+//========================================================================
+// Project     : M-Vicuna
+// Name        : superkmer.hpp
+// Author      : agent
+// Created on  : Oct 19, 2026
+// Version     : 1.0
+// Copyright   : The Broad Institute
+//  				 SOFTWARE COPYRIGHT NOTICE AGREEMENT
+// 				 This software and its documentation are copyright (2026)
+//				 by the Broad Institute. All rights are reserved.
+//
+// 				 This software is supplied without any warranty or
+//				 guaranteed support whatsoever. The Broad Institute cannot
+//				 be responsible for its use,	misuse, or functionality.
+// Description : Minimiser partitioning of k-mers into super-k-mers
+//========================================================================
+
+
+#ifndef SUPERKMER_HPP_
+#define SUPERKMER_HPP_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "xny/seq_kernel.hpp"
+#include "../jaz/hash.hpp"
+
+namespace xny{
+	/**
+	 * Partition of the k-mers of sequences into [bins] by minimiser
+	 * (Deorowicz et al. 2015, KMC 2): consecutive k-mers sharing their
+	 * minimiser form a super-k-mer, which is stored once for all its
+	 * k-mers. Minimisers are taken over canonical m-mers, so a k-mer and
+	 * its reverse complement fall into the same bin.
+	 *
+	 * The super-k-mers of one sequence that fall into the same bin are
+	 * appended to that bin's buffer as one group, so the k-mers of a
+	 * sequence are still seen together when a bin is counted:
+	 *
+	 *   group         uint32_t number of super-k-mers, then each as
+	 *   super-k-mer   uint32_t length, (length + 3) / 4 bytes of 2 bit
+	 *                 codes, 4 bases per byte, first base lowest
+	 */
+	class superkmer_partitioner {
+	public:
+		/** constructor superkmer_partitioner ()
+		 *
+		 * [k] <= 32, minimisers of min (k, [m]) bases
+		 */
+		superkmer_partitioner (int k, int bins, int m = 9):
+			k_ (k), m_ (std::min (k, m)), bins_ (bins) {}
+
+		int bins () const { return bins_; }
+
+		/** Function: add ()
+		 *  Append the groups of [seq] of length [len] to [bufs], one
+		 *  buffer per bin
+		 */
+		void add (const char* seq, int len, std::vector<std::string>& bufs) {
+			parts_.clear();
+			code_.resize (len + 1);
+			if (seq_encode (seq, len, &code_[0]) == 0) {
+				if (len >= k_) split (0, len);
+			} else {
+				int s = 0;
+				while (s < len) { // runs of ACGT bases
+					while (s < len && code_[s] == 4) ++ s;
+					int e = s;
+					while (e < len && code_[e] != 4) ++ e;
+					if (e - s >= k_) split (s, e);
+					s = e;
+				}
+			}
+			std::stable_sort (parts_.begin(), parts_.end(), cmp_bin);
+			for (int i = 0; i < (int) parts_.size(); ) {
+				int j = i;
+				while (j < (int) parts_.size() && parts_[j].bin == parts_[i].bin) ++ j;
+				std::string& buf = bufs[parts_[i].bin];
+				put (buf, j - i);
+				for (; i < j; ++ i) pack (buf, &code_[parts_[i].beg], parts_[i].len);
+			}
+		} // add
+
+		/** Function: next_group ()
+		 *  Decode the group of a bin buffer [buf] at [pos] into ACGT
+		 *  strings [seqs], advance [pos]; return false at the end
+		 */
+		static bool next_group (const std::string& buf, size_t& pos,
+				std::vector<std::string>& seqs) {
+			if (pos + sizeof (uint32_t) > buf.size()) return false;
+			uint32_t n = get (buf, pos);
+			seqs.resize (n);
+			for (uint32_t i = 0; i < n; ++ i) {
+				uint32_t len = get (buf, pos);
+				seqs[i].resize (len);
+				for (uint32_t j = 0; j < len; ++ j) {
+					seqs[i][j] = "ACGT"[((unsigned char) buf[pos + j / 4] >> (2 * (j % 4))) & 3];
+				}
+				pos += (len + 3) / 4;
+			}
+			return true;
+		} // next_group
+
+	private:
+		struct part_t {
+			int bin, beg, len;
+		};
+		int k_, m_, bins_;
+		std::vector<part_t> parts_;
+		std::vector<uint8_t> code_; // 2 bit codes of the sequence, 4 for non-ACGT
+		std::vector<uint64_t> order_; // order of the canonical m-mer at a position
+
+		static bool cmp_bin (const part_t& a, const part_t& b) {
+			return a.bin < b.bin;
+		}
+
+		/* super-k-mers of the ACGT run [s, e) */
+		void split (int s, int e) {
+			int n = e - s - m_ + 1;
+			order_.resize (n);
+			uint64_t mask = (m_ == 32) ? ~ (uint64_t) 0 : (((uint64_t) 1 << (2 * m_)) - 1);
+			uint64_t fwd = 0, rvc = 0;
+			for (int i = 0; i < e - s; ++ i) {
+				int c = code_[s + i];
+				fwd = ((fwd << 2) | c) & mask;
+				rvc = (rvc >> 2) | ((uint64_t) (3 - c) << (2 * (m_ - 1)));
+				if (i >= m_ - 1) order_[i - m_ + 1] = std::min (fwd, rvc);
+			}
+			// a bijection: distinct m-mers never tie
+			jaz::mxs64 () (&order_[0], n, &order_[0]);
+
+			int w = k_ - m_ + 1; // m-mers per k-mer
+			int mp = -1, beg = 0; // minimiser position, super-k-mer start
+			for (int i = 0; i + w <= n; ++ i) { // k-mer at s + i
+				int prev = mp;
+				if (mp < i) {
+					mp = i;
+					for (int j = i + 1; j < i + w; ++ j) {
+						if (order_[j] < order_[mp]) mp = j;
+					}
+				} else if (order_[i + w - 1] < order_[mp]) {
+					mp = i + w - 1;
+				}
+				if (prev != -1 && order_[mp] != order_[prev]) {
+					emit (s + beg, i - beg + k_ - 1, order_[prev]);
+					beg = i;
+				}
+			}
+			emit (s + beg, n - w + 1 - beg + k_ - 1, order_[mp]);
+		} // split
+
+		void emit (int beg, int len, uint64_t minimiser) {
+			part_t p = { (int) (minimiser % bins_), beg, len };
+			parts_.push_back (p);
+		}
+
+		static void put (std::string& buf, uint32_t x) {
+			buf.append ((const char*) &x, sizeof (x));
+		}
+
+		static uint32_t get (const std::string& buf, size_t& pos) {
+			uint32_t x;
+			buf.copy ((char*) &x, sizeof (x), pos);
+			pos += sizeof (x);
+			return x;
+		}
+
+		static void pack (std::string& buf, const uint8_t* code, int len) {
+			put (buf, len);
+			size_t pos = buf.size();
+			buf.resize (pos + (len + 3) / 4);
+			seq_pack (code, len, (uint8_t*) &buf[pos]);
+		}
+	}; // class superkmer_partitioner
+
+} // namespace xny
+
+#endif /* SUPERKMER_HPP_ */
@@ -42,6 +42,7 @@ typedef std::vector<char> cvec_t;
 typedef std::vector<bool> bvec_t;
 typedef std::vector<ivec_t> iivec_t;
 typedef std::vector<uint32_t> uvec_t;
+typedef std::vector<uint64_t> u64vec_t;
 typedef std::vector<uvec_t> uuvec_t;
 typedef std::vector<std::string> strvec_t;
 typedef std::pair<int, int> ipair_t;